@@ -0,0 +1,428 @@
+#include "ggmorse/ggmorse.h"
+
+#include "ggmorse-common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char * kMessage = "CQ CQ CQ DE GGMORSE GGMORSE K THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789";
+
+const float kSkimmerFrequencyMin_hz = 300.0f;
+const float kSkimmerFrequencyMax_hz = 1800.0f;
+
+const char * formatName(GGMorse::SampleFormat format) {
+    switch (format) {
+        case GGMORSE_SAMPLE_FORMAT_UNDEFINED: return "undefined";
+        case GGMORSE_SAMPLE_FORMAT_U8:        return "u8";
+        case GGMORSE_SAMPLE_FORMAT_I8:        return "i8";
+        case GGMORSE_SAMPLE_FORMAT_U16:       return "u16";
+        case GGMORSE_SAMPLE_FORMAT_I16:       return "i16";
+        case GGMORSE_SAMPLE_FORMAT_F32:       return "f32";
+        case GGMORSE_SAMPLE_FORMAT_I24:       return "i24";
+        case GGMORSE_SAMPLE_FORMAT_I32:       return "i32";
+        case GGMORSE_SAMPLE_FORMAT_F64:       return "f64";
+    }
+
+    return "unknown";
+}
+
+// store float samples in the given format
+std::vector<uint8_t> toFormat(const std::vector<float> & samples, GGMorse::SampleFormat format) {
+    std::vector<uint8_t> result;
+
+    auto append = [&](const auto value) {
+        const auto p = (const uint8_t *) &value;
+        result.insert(result.end(), p, p + sizeof(value));
+    };
+
+    for (const auto x : samples) {
+        switch (format) {
+            case GGMORSE_SAMPLE_FORMAT_UNDEFINED: break;
+            case GGMORSE_SAMPLE_FORMAT_U8:  append(uint8_t(128 + 127*x)); break;
+            case GGMORSE_SAMPLE_FORMAT_I8:  append(int8_t(127*x)); break;
+            case GGMORSE_SAMPLE_FORMAT_U16: append(uint16_t(32768 + 32767*x)); break;
+            case GGMORSE_SAMPLE_FORMAT_I16: append(int16_t(32767*x)); break;
+            case GGMORSE_SAMPLE_FORMAT_F32: append(float(x)); break;
+            case GGMORSE_SAMPLE_FORMAT_I24:
+                {
+                    const int32_t v = int32_t(8388607*x);
+                    result.push_back(v & 0xff);
+                    result.push_back((v >> 8) & 0xff);
+                    result.push_back((v >> 16) & 0xff);
+                } break;
+            case GGMORSE_SAMPLE_FORMAT_I32: append(int32_t(2147483647.0*x)); break;
+            case GGMORSE_SAMPLE_FORMAT_F64: append(double(x)); break;
+        }
+    }
+
+    return result;
+}
+
+// parameters of an encoder with the given output sample rate and format
+GGMorse::Parameters getParametersEncoder(float sampleRate, GGMorse::SampleFormat format) {
+    auto parameters = GGMorse::getDefaultParameters();
+    parameters.sampleRateOut = sampleRate;
+    parameters.sampleFormatOut = format;
+
+    return parameters;
+}
+
+// parameters of a decoder with the given capture sample rate and format
+GGMorse::Parameters getParametersDecoder(float sampleRate, GGMorse::SampleFormat format) {
+    auto parameters = GGMorse::getDefaultParameters();
+    parameters.sampleRateInp = sampleRate;
+    parameters.sampleFormatInp = format;
+
+    return parameters;
+}
+
+// generate nSignals Morse code signals, spread over the skimmer frequency range with different speeds
+std::vector<uint8_t> generateSkimmer(float sampleRate, GGMorse::SampleFormat format, float duration_s, int nSignals) {
+    std::vector<float> result(duration_s*sampleRate, 0.0f);
+
+    for (int i = 0; i < nSignals; ++i) {
+        const float frequency_hz = kSkimmerFrequencyMin_hz + (i + 0.5f)*(kSkimmerFrequencyMax_hz - kSkimmerFrequencyMin_hz)/nSignals;
+        const float speed_wpm = 15.0f + (7*i)%20;
+
+        GGMorseEncoder ggMorse(getParametersEncoder(sampleRate, GGMORSE_SAMPLE_FORMAT_F32));
+
+        ggMorse.setParametersEncode({ 0.5f, frequency_hz, speed_wpm, speed_wpm, false });
+        ggMorse.init((int) strlen(kMessage), kMessage);
+
+        std::vector<float> message;
+        ggMorse.encode([&](const void * data, uint32_t nBytes) {
+            message.insert(message.end(), (const float *) data, (const float *) data + nBytes/sizeof(float));
+        });
+
+        // the signals are keyed independently
+        const size_t offset = (i*message.size())/nSignals;
+        for (size_t j = 0; j < result.size(); ++j) {
+            result[j] += message[(j + offset) % message.size()]/nSignals;
+        }
+    }
+
+    return toFormat(result, format);
+}
+
+// generate a Morse code waveform with the given sample rate and format
+std::vector<uint8_t> generate(float sampleRate, GGMorse::SampleFormat format, float duration_s) {
+    GGMorseEncoder ggMorse(getParametersEncoder(sampleRate, format));
+
+    ggMorse.setParametersEncode({ 0.5f, 600.0f, 25.0f, 25.0f, false });
+    ggMorse.init((int) strlen(kMessage), kMessage);
+
+    std::vector<uint8_t> message;
+    ggMorse.encode([&](const void * data, uint32_t nBytes) {
+        message.insert(message.end(), (const uint8_t *) data, (const uint8_t *) data + nBytes);
+    });
+
+    const size_t nBytesTotal = duration_s*sampleRate*ggMorse.getSampleSizeBytesOut();
+
+    std::vector<uint8_t> result;
+    result.reserve(nBytesTotal + message.size());
+    while (result.size() < nBytesTotal) {
+        result.insert(result.end(), message.begin(), message.end());
+    }
+
+    return result;
+}
+
+// encode nMessages short messages one at a time and in batches, and print the throughput
+void benchEncode(float sampleRate, GGMorse::SampleFormat format, int nMessages) {
+    const auto parameters = getParametersEncoder(sampleRate, format);
+
+    const int nThreadsMax = std::max(1, (int) std::thread::hardware_concurrency());
+    GGMorseBatchEncoder batchEncoder(parameters, nThreadsMax);
+
+    // a few different speeds and tones, as in a burst of requests from different users
+    std::vector<GGMorseBatchEncoder::Message> messages(nMessages);
+    std::vector<std::vector<uint8_t>> outputs(nMessages);
+    for (int i = 0; i < nMessages; ++i) {
+        auto & message = messages[i];
+        message.text = std::string(kMessage).substr((7*i) % 40, 20 + (13*i) % 40);
+        message.parameters = { 0.5f, 500.0f + 50.0f*(i % 4), 20.0f + 5.0f*(i % 3), 20.0f + 5.0f*(i % 3), false };
+
+        const uint32_t nBytes = batchEncoder.encodeSize_bytes(message);
+        if (nBytes == 0) {
+            fprintf(stderr, "Failed to compute the size of message %d\n", i);
+            return;
+        }
+
+        outputs[i].resize(nBytes);
+        message.output = outputs[i].data();
+        message.nMaxBytes = (uint32_t) outputs[i].size();
+        message.nBytes = 0;
+    }
+
+    const int sampleSizeBytes = GGMorseEncoder(parameters).getSampleSizeBytesOut();
+
+    auto report = [&](const char * method, float time_ms) {
+        size_t nBytesTotal = 0;
+        for (const auto & message : messages) {
+            nBytesTotal += message.nBytes;
+        }
+
+        const float audio_s = float(nBytesTotal/sampleSizeBytes)/sampleRate;
+
+        fprintf(stderr, "%8d %6s %12s %10.1f %14.1f %14.1f\n",
+                (int) sampleRate, formatName(format), method, time_ms, 1e3*nMessages/time_ms, 1e3*audio_s/time_ms);
+    };
+
+    // the messages one at a time, with a new encoder for each one
+    {
+        const auto tStart = std::chrono::high_resolution_clock::now();
+
+        for (auto & message : messages) {
+            GGMorseEncoder ggMorse(parameters);
+            ggMorse.setParametersEncode(message.parameters);
+            ggMorse.init((int) message.text.size(), message.text.data());
+
+            message.nBytes = 0;
+            ggMorse.encode([&](const void * data, uint32_t nBytes) {
+                memcpy((uint8_t *) message.output + message.nBytes, data, nBytes);
+                message.nBytes += nBytes;
+            });
+        }
+
+        report("one-by-one", getTime_ms(tStart, std::chrono::high_resolution_clock::now()));
+    }
+
+    for (int nThreads = 1; nThreads <= nThreadsMax; nThreads *= 2) {
+        GGMorseBatchEncoder encoder(parameters, nThreads);
+
+        // warm up the threads and the element templates
+        encoder.encode(messages);
+
+        const auto tStart = std::chrono::high_resolution_clock::now();
+
+        encoder.encode(messages);
+
+        const std::string method = "batch x" + std::to_string(nThreads);
+        report(method.c_str(), getTime_ms(tStart, std::chrono::high_resolution_clock::now()));
+    }
+}
+
+
+void benchDecodePool(float sampleRate, GGMorse::SampleFormat format, const GGMorse::ParametersDecode & parametersDecode, float duration_s, int nDecoders) {
+    const auto parameters = getParametersDecoder(sampleRate, format);
+
+    // uneven amounts of work - the signals are from 1/4 to the whole duration long
+    std::vector<std::vector<uint8_t>> signals(4);
+    for (int k = 0; k < 4; ++k) {
+        signals[k] = generate(sampleRate, format, 0.25f*(k + 1)*duration_s);
+    }
+
+    // the audio arrives in chunks of one second, in turn from all decoders
+    const size_t nChunkBytes = sampleRate*GGMorseDecoder(parameters).getSampleSizeBytesInp();
+
+    double audio_s = 0.0;
+    for (int i = 0; i < nDecoders; ++i) {
+        audio_s += 0.25f*(i % 4 + 1)*duration_s;
+    }
+
+    auto report = [&](const char * method, float time_ms) {
+        fprintf(stderr, "%8d %6s %12s %10.1f %14.1f\n", (int) sampleRate, formatName(format), method, time_ms, 1e3*audio_s/time_ms);
+    };
+
+    auto newDecoders = [&]() {
+        std::vector<std::unique_ptr<GGMorseDecoder>> decoders;
+        for (int i = 0; i < nDecoders; ++i) {
+            decoders.emplace_back(new GGMorseDecoder(parameters));
+            decoders.back()->setParametersDecode(parametersDecode);
+        }
+        return decoders;
+    };
+
+    // the decoders one at a time, on the calling thread
+    {
+        auto decoders = newDecoders();
+
+        const auto tStart = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < nDecoders; ++i) {
+            const auto & signal = signals[i % 4];
+            decoders[i]->decode(signal.data(), signal.size());
+        }
+
+        report("one-by-one", getTime_ms(tStart, std::chrono::high_resolution_clock::now()));
+    }
+
+    const int nThreadsMax = std::max(1, (int) std::thread::hardware_concurrency());
+    for (int nThreads = 1; nThreads <= nThreadsMax; nThreads *= 2) {
+        GGMorseDecoderPool pool(nThreads);
+
+        auto decoders = newDecoders();
+
+        const auto tStart = std::chrono::high_resolution_clock::now();
+
+        bool hasMore = true;
+        for (size_t offset = 0; hasMore; offset += nChunkBytes) {
+            hasMore = false;
+            for (int i = 0; i < nDecoders; ++i) {
+                const auto & signal = signals[i % 4];
+                if (offset < signal.size()) {
+                    pool.decode(*decoders[i], signal.data() + offset, std::min(nChunkBytes, signal.size() - offset));
+                    hasMore = true;
+                }
+            }
+        }
+
+        pool.wait();
+
+        const std::string method = "pool x" + std::to_string(nThreads);
+        report(method.c_str(), getTime_ms(tStart, std::chrono::high_resolution_clock::now()));
+    }
+}
+
+}
+
+int main(int argc, char ** argv) {
+    fprintf(stderr, "Usage: %s [-tN] [-sN] [-fS] [-dS] [-kN] [-eN] [-mN]\n", argv[0]);
+    fprintf(stderr, "    -tN - duration of the test signal in seconds, (default: 60)\n");
+    fprintf(stderr, "    -sN - capture sample rate, (default: run all)\n");
+    fprintf(stderr, "    -fS - capture sample format: u8, i8, u16, i16, i24, i32, f32, f64, (default: i16 and f32)\n");
+    fprintf(stderr, "    -dS - tone detector: goertzel, nco, fll, (default: goertzel)\n");
+    fprintf(stderr, "    -kN - skimmer mode with N simultaneous signals, (default: off)\n");
+    fprintf(stderr, "    -eN - measure the encoding throughput with N messages instead, (default: off)\n");
+    fprintf(stderr, "    -mN - measure the decoding throughput of N decoders on GGMorseDecoderPool instead, (default: off)\n");
+    fprintf(stderr, "\n");
+
+    auto argm = parseCmdArguments(argc, argv);
+
+    if (argm.find("h") != argm.end()) {
+        return 0;
+    }
+
+    const float duration_s = argm["t"].empty() ? 60.0f : std::stof(argm["t"]);
+
+    std::vector<float> sampleRates = { 4000.0f, 8000.0f, 44100.0f, 48000.0f };
+    if (argm["s"].empty() == false) {
+        sampleRates = { std::stof(argm["s"]) };
+    }
+
+    auto parametersDecode = GGMorse::getDefaultParametersDecode();
+    if (argm["d"] == "nco") {
+        parametersDecode.toneDetector = GGMORSE_TONE_DETECTOR_NCO;
+    } else if (argm["d"] == "fll") {
+        parametersDecode.toneDetector = GGMORSE_TONE_DETECTOR_FLL;
+    } else if (argm["d"].empty() == false && argm["d"] != "goertzel") {
+        fprintf(stderr, "Unknown tone detector: %s\n", argm["d"].c_str());
+        return -1;
+    }
+
+    const int nSignals = argm["k"].empty() ? 0 : std::stoi(argm["k"]);
+    if (nSignals > 0) {
+        parametersDecode.skimmer = true;
+        parametersDecode.frequencyRangeMin_hz = kSkimmerFrequencyMin_hz - 100.0f;
+        parametersDecode.frequencyRangeMax_hz = kSkimmerFrequencyMax_hz + 100.0f;
+    }
+
+    std::vector<GGMorse::SampleFormat> formats = { GGMORSE_SAMPLE_FORMAT_I16, GGMORSE_SAMPLE_FORMAT_F32 };
+    if (argm["f"].empty() == false) {
+        formats.clear();
+        for (int f = GGMORSE_SAMPLE_FORMAT_U8; f <= GGMORSE_SAMPLE_FORMAT_F64; ++f) {
+            if (argm["f"] == formatName((GGMorse::SampleFormat) f)) {
+                formats.push_back((GGMorse::SampleFormat) f);
+            }
+        }
+        if (formats.empty()) {
+            fprintf(stderr, "Unknown sample format: %s\n", argm["f"].c_str());
+            return -1;
+        }
+    }
+
+    const int nMessages = argm["e"].empty() ? 0 : std::stoi(argm["e"]);
+    if (nMessages > 0) {
+        fprintf(stderr, "%8s %6s %12s %10s %14s %14s\n", "rate", "format", "method", "time [ms]", "messages/s", "audio s/s");
+
+        for (const auto sampleRate : sampleRates) {
+            for (const auto format : formats) {
+                benchEncode(sampleRate, format, nMessages);
+            }
+        }
+
+        return 0;
+    }
+
+    const int nDecoders = argm["m"].empty() ? 0 : std::stoi(argm["m"]);
+    if (nDecoders > 0) {
+        fprintf(stderr, "%8s %6s %12s %10s %14s\n", "rate", "format", "method", "time [ms]", "audio s/s");
+
+        for (const auto sampleRate : sampleRates) {
+            for (const auto format : formats) {
+                benchDecodePool(sampleRate, format, parametersDecode, duration_s, nDecoders);
+            }
+        }
+
+        return 0;
+    }
+
+    fprintf(stderr, "%8s %6s %10s %10s %12s %12s %14s\n", "rate", "format", "samples", "time [ms]", "ns/sample", "x realtime", "input ns/sample");
+
+    for (const auto sampleRate : sampleRates) {
+        for (const auto format : formats) {
+            const auto samples = nSignals > 0 ?
+                generateSkimmer(sampleRate, format, duration_s, nSignals) :
+                generate(sampleRate, format, duration_s);
+
+            GGMorseDecoder ggMorse(getParametersDecoder(sampleRate, format));
+            ggMorse.setParametersDecode(parametersDecode);
+
+            const size_t nBytesTotal = samples.size();
+            size_t nBytesRead = 0;
+
+            // provide at most one frame per decode() call, so that the per-frame statistics can be accumulated
+            bool hasProvided = false;
+            GGMorse::CBWaveformInp cbWaveformInp = [&](void * data, uint32_t nMaxBytes) {
+                if (hasProvided || nBytesRead + nMaxBytes > nBytesTotal) {
+                    return 0u;
+                }
+                hasProvided = true;
+
+                memcpy(data, samples.data() + nBytesRead, nMaxBytes);
+                nBytesRead += nMaxBytes;
+
+                return nMaxBytes;
+            };
+
+            const auto tStart = std::chrono::high_resolution_clock::now();
+
+            float timeInput_ms = 0.0f;
+
+            size_t nBytesReadLast = 0;
+            do {
+                nBytesReadLast = nBytesRead;
+                hasProvided = false;
+                if (ggMorse.decode(cbWaveformInp)) {
+                    timeInput_ms += ggMorse.getStatistics().timeResample_ms;
+                }
+            } while (nBytesRead != nBytesReadLast);
+
+            const auto tEnd = std::chrono::high_resolution_clock::now();
+
+            const float time_ms = getTime_ms(tStart, tEnd);
+            const size_t nSamples = nBytesRead/ggMorse.getSampleSizeBytesInp();
+
+            fprintf(stderr, "%8d %6s %10d %10.1f %12.1f %12.1f %14.1f\n",
+                    (int) sampleRate, formatName(format), (int) nSamples, time_ms,
+                    1e6*time_ms/nSamples, (1e3*nSamples/sampleRate)/time_ms, 1e6*timeInput_ms/nSamples);
+
+            if (nSignals > 0) {
+                std::vector<GGMorse::SkimmerData> signals;
+                ggMorse.takeSkimmerData(signals);
+
+                for (const auto & signal : signals) {
+                    printf("%7.1f Hz: %.*s\n", signal.frequency_hz, (int) signal.rxData.size(), (const char *) signal.rxData.data());
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -184,7 +184,7 @@ bool GGMorse_init(
         case AUDIO_S8:      sampleFormatInp = GGMORSE_SAMPLE_FORMAT_I8;  break;
         case AUDIO_U16SYS:  sampleFormatInp = GGMORSE_SAMPLE_FORMAT_U16; break;
         case AUDIO_S16SYS:  sampleFormatInp = GGMORSE_SAMPLE_FORMAT_I16; break;
-        case AUDIO_S32SYS:  sampleFormatInp = GGMORSE_SAMPLE_FORMAT_F32; break;
+        case AUDIO_S32SYS:  sampleFormatInp = GGMORSE_SAMPLE_FORMAT_I32; break;
         case AUDIO_F32SYS:  sampleFormatInp = GGMORSE_SAMPLE_FORMAT_F32; break;
     }
 
@@ -193,7 +193,7 @@ bool GGMorse_init(
         case AUDIO_S8:      sampleFormatOut = GGMORSE_SAMPLE_FORMAT_I8;  break;
         case AUDIO_U16SYS:  sampleFormatOut = GGMORSE_SAMPLE_FORMAT_U16; break;
         case AUDIO_S16SYS:  sampleFormatOut = GGMORSE_SAMPLE_FORMAT_I16; break;
-        case AUDIO_S32SYS:  sampleFormatOut = GGMORSE_SAMPLE_FORMAT_F32; break;
+        case AUDIO_S32SYS:  sampleFormatOut = GGMORSE_SAMPLE_FORMAT_I32; break;
         case AUDIO_F32SYS:  sampleFormatOut = GGMORSE_SAMPLE_FORMAT_F32; break;
             break;
     }
@@ -204,7 +204,12 @@ bool GGMorse_init(
             (float) g_obtainedSpecOut.freq,
             GGMorse::kDefaultSamplesPerFrame,
             sampleFormatInp,
-            sampleFormatOut});
+            sampleFormatOut,
+            g_obtainedSpecInp.channels,
+            GGMORSE_CHANNEL_MODE_DOWNMIX,
+            0,
+            GGMORSE_INPUT_MODE_AUDIO,
+            0.0f});
     }
 
     return true;
@@ -221,17 +226,20 @@ bool GGMorse_mainLoop() {
         SDL_QueueAudio(g_devIdOut, data, nBytes);
     };
 
-    static GGMorse::CBWaveformInp cbWaveformInp = [&](void * data, uint32_t nMaxBytes) {
-        if (SDL_GetQueuedAudioSize(g_devIdInp) < nMaxBytes) {
-            return 0u;
-        }
-        return SDL_DequeueAudio(g_devIdInp, data, nMaxBytes);
-    };
+    static std::vector<uint8_t> bufferInp;
 
     if (g_ggMorse->hasTxData() == false) {
         SDL_PauseAudioDevice(g_devIdOut, SDL_FALSE);
         SDL_PauseAudioDevice(g_devIdInp, SDL_FALSE);
-        g_ggMorse->decode(cbWaveformInp);
+
+        // push all queued audio - incomplete frames are kept by the decoder until the next call
+        const uint32_t nBytesQueued = SDL_GetQueuedAudioSize(g_devIdInp);
+        if (nBytesQueued > 0) {
+            bufferInp.resize(nBytesQueued);
+            const uint32_t nBytesDequeued = SDL_DequeueAudio(g_devIdInp, bufferInp.data(), nBytesQueued);
+            g_ggMorse->decode(bufferInp.data(), nBytesDequeued);
+        }
+
         if ((int) SDL_GetQueuedAudioSize(g_devIdInp) > 32*g_ggMorse->getSamplesPerFrame()*g_ggMorse->getSampleSizeBytesInp()) {
             fprintf(stderr, "Warning: slow processing, clearing queued audio buffer of %d bytes ...\n", SDL_GetQueuedAudioSize(g_devIdInp));
             SDL_ClearQueuedAudio(g_devIdInp);
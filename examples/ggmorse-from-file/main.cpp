@@ -5,14 +5,17 @@
 
 #include "ggmorse-common.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
 
 int main(int argc, char** argv) {
-    fprintf(stderr, "Usage: %s audio.wav [-fN] [-wN]\n", argv[0]);
+    fprintf(stderr, "Usage: %s audio.wav [-fN] [-wN] [-cN] [-k]\n", argv[0]);
     fprintf(stderr, "    -fN - frequency of the sound in HZ, N in [200, 1200], (default: auto)\n");
     fprintf(stderr, "    -wN - speed of the transmission in words-per-minute, N in [5, 55], (default: auto)\n");
+    fprintf(stderr, "    -cN - channel to decode, (default: downmix all channels)\n");
+    fprintf(stderr, "    -k  - skimmer mode - decode all signals in the frequency range\n");
     fprintf(stderr, "\n");
 
     if (argc < 2) {
@@ -27,6 +30,8 @@ int main(int argc, char** argv) {
 
     float frequency_hz = argm["f"].empty() ? -1.0 : std::stof(argm["f"]);
     float speed_wpm = argm["w"].empty() ? -1.0 : std::stof(argm["w"]);
+    int channel = argm["c"].empty() ? -1 : std::stoi(argm["c"]);
+    bool skimmer = argm.find("k") != argm.end();
 
     if (frequency_hz > 0.0f && (frequency_hz < 100 || frequency_hz > GGMorse::kBaseSampleRate/2 + 1)) {
         fprintf(stderr, "Invalid frequency\n");
@@ -44,8 +49,8 @@ int main(int argc, char** argv) {
         return -4;
     }
 
-    if (wav.channels != 1) {
-        fprintf(stderr, "Only mono WAV files are supported\n");
+    if (channel >= (int) wav.channels) {
+        fprintf(stderr, "Invalid channel\n");
         return -5;
     }
 
@@ -64,44 +69,25 @@ int main(int argc, char** argv) {
 
     printf("[+] Decoding: \n\n");
 
-    auto parameters = GGMorse::Parameters {
-        (float) wav.sampleRate,
-        (float) wav.sampleRate,
-        GGMorse::kDefaultSamplesPerFrame,
-        GGMORSE_SAMPLE_FORMAT_I16,
-        GGMORSE_SAMPLE_FORMAT_I16
-    };
+    auto parameters = GGMorse::getDefaultParameters();
+    parameters.sampleRateInp = wav.sampleRate;
+    parameters.sampleRateOut = wav.sampleRate;
+    parameters.sampleFormatInp = GGMORSE_SAMPLE_FORMAT_I16;
+    parameters.sampleFormatOut = GGMORSE_SAMPLE_FORMAT_I16;
+    parameters.channelsInp = wav.channels;
+    parameters.channelModeInp = channel < 0 ? GGMORSE_CHANNEL_MODE_DOWNMIX : GGMORSE_CHANNEL_MODE_SELECT;
+    parameters.channelInp = channel < 0 ? 0 : channel;
 
     switch (wav.bitsPerSample) {
         case 16:
             drwav_read_pcm_frames_s16(&wav, samplesCount, reinterpret_cast<int16_t*>(samples.data()));
 
-            if (wav.channels > 1) {
-                for (size_t i = 0; i < samplesCount; ++i) {
-                    int16_t sample = 0;
-                    for (size_t j = 0; j < wav.channels; ++j) {
-                        sample += reinterpret_cast<int16_t*>(samples.data())[i*wav.channels + j];
-                    }
-                    reinterpret_cast<int16_t*>(samples.data())[i] = sample / wav.channels;
-                }
-            }
-
             parameters.sampleFormatInp = GGMORSE_SAMPLE_FORMAT_I16;
 
             break;
         case 32:
             drwav_read_pcm_frames_f32(&wav, samplesCount, reinterpret_cast<float*>(samples.data()));
 
-            if (wav.channels > 1) {
-                for (size_t i = 0; i < samplesCount; ++i) {
-                    float sample = 0.0f;
-                    for (size_t j = 0; j < wav.channels; ++j) {
-                        sample += reinterpret_cast<float*>(samples.data())[i*wav.channels + j];
-                    }
-                    reinterpret_cast<float*>(samples.data())[i] = sample / wav.channels;
-                }
-            }
-
             parameters.sampleFormatInp = GGMORSE_SAMPLE_FORMAT_F32;
 
             break;
@@ -110,28 +96,34 @@ int main(int argc, char** argv) {
             return -6;
     }
 
-    GGMorse ggMorse(parameters);
+    GGMorseDecoder ggMorse(parameters);
 
     {
         auto parametersDecode = ggMorse.getDefaultParametersDecode();
         parametersDecode.frequency_hz = frequency_hz;
         parametersDecode.speed_wpm = speed_wpm;
+        parametersDecode.skimmer = skimmer;
         ggMorse.setParametersDecode(parametersDecode);
     }
 
-    uint32_t nSamplesHave = samplesTotal;
-    GGMorse::CBWaveformInp cbWaveformInp = [&](void * data, uint32_t nMaxBytes) {
-        if (nSamplesHave*samplesSize < nMaxBytes) {
-            return 0;
-        }
+    ggMorse.decode(samples.data(), samples.size());
 
-        nSamplesHave -= nMaxBytes/samplesSize;
-        memcpy(data, samples.data() + (samplesTotal - nSamplesHave)*samplesSize, nMaxBytes);
+    if (skimmer == false) {
+        GGMorse::TxRx rxData;
+        const int nRxData = ggMorse.takeRxData(rxData);
 
-        return (int) nMaxBytes;
-    };
+        printf("%.*s", nRxData, (const char *) rxData.data());
+    } else {
+        std::vector<GGMorse::SkimmerData> signals;
+        ggMorse.takeSkimmerData(signals);
 
-    ggMorse.decode(cbWaveformInp);
+        // in the order in which the signals appeared
+        std::sort(signals.begin(), signals.end(), [](const auto & a, const auto & b) { return a.id < b.id; });
+
+        for (const auto & signal : signals) {
+            printf("%7.1f Hz %3.0f wpm: %.*s\n", signal.frequency_hz, signal.speed_wpm, (int) signal.rxData.size(), (const char *) signal.rxData.data());
+        }
+    }
 
     printf("\n\n[+] Done\n");
 
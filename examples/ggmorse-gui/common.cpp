@@ -1394,7 +1394,8 @@ void renderMain() {
                             {
                                 settings.volume, settings.txFrequency_hz,
                                 (float) settings.txSpeedCharacters_wpm,
-                                (float) settings.txSpeedFarnsworth_wpm
+                                (float) settings.txSpeedFarnsworth_wpm,
+                                true,
                             }
                         };
 
@@ -0,0 +1,762 @@
+#include "ggmorse/ggmorse.h"
+
+#include "ggmorse-common.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// the header line of a stream is at most this long
+constexpr int kMaxHeaderSize = 1024;
+
+// reading from a stream is paused while this much of its audio waits to be decoded
+constexpr float kMaxBacklog_s = 10.0f;
+
+// reading from a stream is also paused while this much of its text waits to be sent
+constexpr int kMaxPendingText = 64*1024;
+
+// the epoll data of the listening socket - the events of the streams carry the id of the stream
+constexpr uint64_t kListenEvent = UINT64_MAX;
+
+using Clock = std::chrono::high_resolution_clock;
+
+struct Address {
+    std::string path;   // UNIX socket
+    int port = 0;       // TCP port on the loopback interface
+};
+
+int openSocket(const Address & address, bool isServer) {
+    const int fd = socket(address.path.empty() ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un addrUnix = {};
+    sockaddr_in addrInet = {};
+    sockaddr * addr = nullptr;
+    socklen_t addrSize = 0;
+
+    if (address.path.empty() == false) {
+        if (address.path.size() >= sizeof(addrUnix.sun_path)) {
+            close(fd);
+            return -1;
+        }
+
+        addrUnix.sun_family = AF_UNIX;
+        strcpy(addrUnix.sun_path, address.path.c_str());
+        addr = (sockaddr *) &addrUnix;
+        addrSize = sizeof(addrUnix);
+    } else {
+        addrInet.sin_family = AF_INET;
+        addrInet.sin_port = htons(address.port);
+        addrInet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr = (sockaddr *) &addrInet;
+        addrSize = sizeof(addrInet);
+    }
+
+    if (isServer) {
+        if (address.path.empty() == false) {
+            unlink(address.path.c_str());
+        } else {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+
+        if (bind(fd, addr, addrSize) != 0 || listen(fd, 1024) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else if (connect(fd, addr, addrSize) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void sendAll(int fd, const void * data, size_t nBytes) {
+    size_t nSent = 0;
+    while (nSent < nBytes) {
+        const ssize_t n = send(fd, (const char *) data + nSent, nBytes - nSent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        nSent += n;
+    }
+}
+
+// parse the options of a header line like "-s8000 -xi16 -f600"
+std::map<std::string, std::string> parseHeader(const std::string & line) {
+    std::map<std::string, std::string> argm;
+
+    size_t pos = 0;
+    while (pos < line.size()) {
+        const size_t end = std::min(line.find(' ', pos), line.size());
+        if (end - pos > 1 && line[pos] == '-') {
+            argm[std::string(1, line[pos + 1])] = line.substr(pos + 2, end - pos - 2);
+        }
+        pos = end + 1;
+    }
+
+    return argm;
+}
+
+GGMorse::SampleFormat parseSampleFormat(const std::string & name) {
+    if (name == "i16") return GGMORSE_SAMPLE_FORMAT_I16;
+    if (name == "f32") return GGMORSE_SAMPLE_FORMAT_F32;
+
+    return GGMORSE_SAMPLE_FORMAT_UNDEFINED;
+}
+
+//
+// server
+//
+
+// one connected PCM stream
+//
+// The I/O thread appends the received audio to the backlog and a worker decodes it. A stream is in the work queue
+// at most once, so its audio is decoded in order and by one worker at a time. The decoded text that does not fit in
+// the socket buffer is kept and sent by the I/O thread when the socket becomes writable.
+//
+struct Stream {
+    int id = 0;
+    int fd = -1;
+
+    std::mutex mutex;
+
+    std::string header;
+    std::unique_ptr<GGMorseDecoder> decoder;
+
+    int sampleSizeBytes = 0;
+    float sampleRate = 0.0f;
+
+    std::vector<uint8_t> backlog;
+    bool isQueued = false;
+    bool isPaused = false;      // reading is paused until the backlog is decoded
+    bool isEOF = false;
+    bool isDecoded = false;     // the end of the stream has been decoded
+    bool isRemoved = false;
+
+    std::string pending;        // decoded text that is not sent yet
+    bool isBroken = false;      // the client does not accept more text
+
+    // counters
+    Clock::time_point tStart;
+    int64_t nSamplesDecoded = 0;
+    int64_t nBytesText = 0;
+    double timeDecode_s = 0.0;
+};
+
+struct Server {
+    int fdListen = -1;
+    int fdEpoll = -1;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<Stream>> queue;
+    std::map<int, std::shared_ptr<Stream>> streams;
+    int nextId = 0;
+
+    // the stream mutex must be held
+    void arm(Stream & stream) {
+        epoll_event event = {};
+        if (stream.isEOF == false && stream.isPaused == false && (int) stream.pending.size() < kMaxPendingText) {
+            event.events |= EPOLLIN;
+        }
+        if (stream.pending.empty() == false) {
+            event.events |= EPOLLOUT;
+        }
+        if (event.events == 0) {
+            return;
+        }
+
+        event.events |= EPOLLONESHOT;
+        event.data.u64 = stream.id;
+        epoll_ctl(fdEpoll, EPOLL_CTL_MOD, stream.fd, &event);
+    }
+
+    // the stream mutex must be held
+    void schedule(const std::shared_ptr<Stream> & stream) {
+        if (stream->isQueued || stream->isDecoded || stream->decoder == nullptr) {
+            return;
+        }
+
+        if ((int) stream->backlog.size() < stream->sampleSizeBytes && stream->isEOF == false) {
+            return;
+        }
+
+        stream->isQueued = true;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(stream);
+        }
+        cv.notify_one();
+    }
+
+    // the stream mutex must be held
+    void remove(Stream & stream) {
+        stream.isRemoved = true;
+        close(stream.fd);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        streams.erase(stream.id);
+    }
+
+    // send as much of the pending text as the socket takes - the stream mutex must be held
+    void flush(Stream & stream) {
+        while (stream.pending.empty() == false) {
+            const ssize_t n = send(stream.fd, stream.pending.data(), stream.pending.size(), MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n <= 0) {
+                stream.pending.clear();
+                stream.isBroken = true;
+                break;
+            }
+            stream.pending.erase(0, n);
+        }
+
+        // the connection is closed only after all of the text is sent
+        if (stream.isDecoded && stream.pending.empty()) {
+            remove(stream);
+        }
+    }
+
+    // I/O thread - the counters of the streams, one line per stream
+    std::string stats() {
+        // the stream mutex is taken before the server mutex elsewhere, so the two are not held together here
+        std::vector<std::shared_ptr<Stream>> cur;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto & it : streams) {
+                cur.push_back(it.second);
+            }
+        }
+
+        const auto tNow = Clock::now();
+
+        std::string result = "   id  sample rate    audio [s]   wall [s]      RTF  backlog [ms]  text [B]\n";
+        for (const auto & it : cur) {
+            auto & stream = *it;
+
+            // the decoder is created by the I/O thread, so it can be checked without the lock
+            if (stream.decoder == nullptr) {
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lockStream(stream.mutex);
+
+            const double audio_s = stream.nSamplesDecoded/stream.sampleRate;
+            const double backlog_ms = 1e3*stream.backlog.size()/stream.sampleSizeBytes/stream.sampleRate;
+
+            char line[256];
+            snprintf(line, sizeof(line), "%5d  %11.0f  %11.2f  %9.2f  %7.4f  %12.1f  %8d\n",
+                     stream.id, stream.sampleRate, audio_s, 1e-3*getTime_ms(stream.tStart, tNow),
+                     audio_s > 0.0 ? stream.timeDecode_s/audio_s : 0.0, backlog_ms, (int) stream.nBytesText);
+            result += line;
+        }
+
+        return result;
+    }
+
+    // the first line of a connection - the format of the stream, or a request for the counters
+    // returns false if the connection is done
+    bool onHeader(const std::shared_ptr<Stream> & stream, std::string line) {
+        if (line.empty() == false && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (line == "stats") {
+            const auto result = stats();
+            sendAll(stream->fd, result.data(), result.size());
+            return false;
+        }
+
+        auto argm = parseHeader(line);
+
+        auto parameters = GGMorse::getDefaultParameters();
+        parameters.sampleRateInp = argm["s"].empty() ? GGMorse::kBaseSampleRate : std::atof(argm["s"].c_str());
+        parameters.sampleFormatInp = argm["x"].empty() ? GGMORSE_SAMPLE_FORMAT_I16 : parseSampleFormat(argm["x"]);
+
+        auto parametersDecode = GGMorse::getDefaultParametersDecode();
+        parametersDecode.frequency_hz = argm["f"].empty() ? -1.0f : std::atof(argm["f"].c_str());
+        parametersDecode.speed_wpm = argm["w"].empty() ? -1.0f : std::atof(argm["w"].c_str());
+
+        std::string error;
+        if (parameters.sampleRateInp < 1000.0f || parameters.sampleRateInp > 192000.0f) {
+            error = "Invalid sample rate";
+        } else if (parameters.sampleFormatInp == GGMORSE_SAMPLE_FORMAT_UNDEFINED) {
+            error = "Invalid sample format";
+        } else {
+            stream->decoder.reset(new GGMorseDecoder(parameters));
+            if (stream->decoder->getSampleSizeBytesInp() == 0 || stream->decoder->setParametersDecode(parametersDecode) == false) {
+                error = "Invalid parameters";
+            }
+        }
+
+        if (error.empty() == false) {
+            stream->decoder.reset();
+
+            error = "ERROR: " + error + "\n";
+            sendAll(stream->fd, error.data(), error.size());
+            return false;
+        }
+
+        stream->sampleSizeBytes = stream->decoder->getSampleSizeBytesInp();
+        stream->sampleRate = parameters.sampleRateInp;
+        stream->tStart = Clock::now();
+
+        return true;
+    }
+
+    // I/O thread - send the pending text and read what has arrived on the stream
+    void onEvent(int id, uint32_t events) {
+        std::shared_ptr<Stream> stream;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = streams.find(id);
+            if (it == streams.end()) {
+                return;
+            }
+            stream = it->second;
+        }
+
+        std::lock_guard<std::mutex> lock(stream->mutex);
+
+        if (stream->isRemoved) {
+            return;
+        }
+
+        if (events & EPOLLOUT) {
+            flush(*stream);
+            if (stream->isRemoved) {
+                return;
+            }
+        }
+
+        uint8_t buffer[64*1024];
+        while (stream->isEOF == false && stream->isPaused == false && (events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+            const ssize_t n = recv(stream->fd, buffer, sizeof(buffer), 0);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            }
+            if (n <= 0) {
+                stream->isEOF = true;
+                break;
+            }
+
+            if (stream->decoder == nullptr) {
+                stream->header.append((const char *) buffer, n);
+
+                const size_t pos = stream->header.find('\n');
+                if (pos == std::string::npos) {
+                    if (stream->header.size() > kMaxHeaderSize) {
+                        stream->isEOF = true;
+                        break;
+                    }
+                    continue;
+                }
+
+                if (onHeader(stream, stream->header.substr(0, pos)) == false) {
+                    stream->isEOF = true;
+                    break;
+                }
+
+                stream->backlog.insert(stream->backlog.end(), stream->header.begin() + pos + 1, stream->header.end());
+                stream->header.clear();
+            } else {
+                stream->backlog.insert(stream->backlog.end(), buffer, buffer + n);
+            }
+
+            if (stream->backlog.size() > kMaxBacklog_s*stream->sampleRate*stream->sampleSizeBytes) {
+                stream->isPaused = true;
+                break;
+            }
+        }
+
+        if (stream->decoder == nullptr && stream->isEOF) {
+            remove(*stream);
+            return;
+        }
+
+        schedule(stream);
+        arm(*stream);
+    }
+
+    // worker thread - decode the backlog of the stream
+    void decode(const std::shared_ptr<Stream> & stream, std::vector<uint8_t> & work, GGMorse::TxRx & text) {
+        bool isEOF = false;
+        {
+            std::lock_guard<std::mutex> lock(stream->mutex);
+            work.swap(stream->backlog);
+            stream->backlog.clear();
+
+            if (stream->isPaused) {
+                stream->isPaused = false;
+                arm(*stream);
+            }
+
+            isEOF = stream->isEOF;
+        }
+
+        const auto tStart = Clock::now();
+
+        stream->decoder->decode(work.data(), work.size());
+
+        // the last character is complete only after a pause, so the end of the stream is followed by silence
+        if (isEOF) {
+            std::vector<uint8_t> silence(GGMorse::kMaxWindowToAnalyze_s*stream->sampleRate*stream->sampleSizeBytes, 0);
+            stream->decoder->decode(silence.data(), silence.size());
+        }
+
+        const int nText = stream->decoder->takeRxData(text);
+
+        const float time_ms = getTime_ms(tStart, Clock::now());
+
+        std::lock_guard<std::mutex> lock(stream->mutex);
+
+        stream->nSamplesDecoded += work.size()/stream->sampleSizeBytes;
+        stream->nBytesText += nText;
+        stream->timeDecode_s += 1e-3*time_ms;
+
+        stream->isQueued = false;
+
+        // the end of the stream may have been reached while decoding - then the silence is decoded on the next pass
+        if (isEOF && stream->backlog.empty()) {
+            stream->isDecoded = true;
+        } else {
+            schedule(stream);
+        }
+
+        if (nText > 0 && stream->isBroken == false) {
+            stream->pending.append((const char *) text.data(), nText);
+        }
+
+        // what does not fit in the socket buffer is sent by the I/O thread
+        flush(*stream);
+        if (stream->isRemoved == false && stream->pending.empty() == false) {
+            arm(*stream);
+        }
+    }
+
+    void work() {
+        std::vector<uint8_t> work;
+        GGMorse::TxRx text;
+
+        while (true) {
+            std::shared_ptr<Stream> stream;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return queue.empty() == false; });
+
+                stream = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            decode(stream, work, text);
+        }
+    }
+
+    int run(const Address & address, int nThreads) {
+        fdListen = openSocket(address, true);
+        fdEpoll = epoll_create1(0);
+        if (fdListen < 0 || fdEpoll < 0) {
+            fprintf(stderr, "Failed to listen on %s\n", address.path.empty() ? std::to_string(address.port).c_str() : address.path.c_str());
+            return -5;
+        }
+
+        fcntl(fdListen, F_SETFL, fcntl(fdListen, F_GETFL) | O_NONBLOCK);
+
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = kListenEvent;
+        epoll_ctl(fdEpoll, EPOLL_CTL_ADD, fdListen, &event);
+
+        fprintf(stderr, "Listening on %s with %d worker threads ...\n", address.path.empty() ? std::to_string(address.port).c_str() : address.path.c_str(), nThreads);
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < nThreads; ++i) {
+            workers.emplace_back([this]() { work(); });
+        }
+
+        epoll_event events[256];
+        while (true) {
+            const int n = epoll_wait(fdEpoll, events, 256, -1);
+
+            for (int i = 0; i < n; ++i) {
+                if (events[i].data.u64 != kListenEvent) {
+                    onEvent(events[i].data.u64, events[i].events);
+                    continue;
+                }
+
+                int fd = -1;
+                while ((fd = accept(fdListen, nullptr, nullptr)) >= 0) {
+                    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+                    auto stream = std::make_shared<Stream>();
+                    stream->fd = fd;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        stream->id = nextId++;
+                        streams[stream->id] = stream;
+                    }
+
+                    epoll_event event = {};
+                    event.events = EPOLLIN | EPOLLONESHOT;
+                    event.data.u64 = stream->id;
+                    epoll_ctl(fdEpoll, EPOLL_CTL_ADD, fd, &event);
+                }
+            }
+        }
+
+        return 0;
+    }
+};
+
+//
+// load generator
+//
+
+int runLoadTest(const Address & address, int nStreams, float duration_s, float sampleRate, bool isRealTime) {
+    // every stream repeats its own message for the duration of the test
+    std::vector<std::vector<int16_t>> waveforms(nStreams);
+    std::vector<std::string> callsigns(nStreams);
+    {
+        auto parameters = GGMorse::getDefaultParameters();
+        parameters.sampleRateOut = sampleRate;
+        parameters.sampleFormatOut = GGMORSE_SAMPLE_FORMAT_I16;
+
+        GGMorseBatchEncoder encoder(parameters);
+
+        std::vector<GGMorseBatchEncoder::Message> messages(nStreams);
+        for (int i = 0; i < nStreams; ++i) {
+            callsigns[i] = "S" + std::to_string(i);
+
+            auto & message = messages[i];
+            message.parameters = GGMorse::getDefaultParametersEncode();
+            message.parameters.volume = 0.5f;
+            message.parameters.frequency_hz = 500.0f + 100.0f*(i % 8);
+            message.parameters.speedCharacters_wpm = 20.0f + 5.0f*(i % 5);
+            message.parameters.speedFarnsworth_wpm = message.parameters.speedCharacters_wpm;
+
+            const std::string text = "CQ CQ DE " + callsigns[i] + " K ";
+            message.text = text;
+
+            const uint32_t nBytesText = encoder.encodeSize_bytes(message);
+            if (nBytesText == 0) {
+                fprintf(stderr, "Failed to generate the test signals\n");
+                return -4;
+            }
+
+            const int nRepeat = std::max(1, (int) (duration_s*sampleRate*sizeof(int16_t)/nBytesText));
+            message.text.clear();
+            for (int k = 0; k < nRepeat; ++k) {
+                message.text += text;
+            }
+
+            const uint32_t nBytes = encoder.encodeSize_bytes(message);
+            if (nBytes == 0) {
+                fprintf(stderr, "The test signals are too long: %g s\n", duration_s);
+                return -4;
+            }
+
+            waveforms[i].resize(nBytes/sizeof(int16_t));
+            message.output = waveforms[i].data();
+            message.nMaxBytes = waveforms[i].size()*sizeof(int16_t);
+        }
+
+        if (encoder.encode(messages) == false) {
+            fprintf(stderr, "Failed to generate the test signals\n");
+            return -4;
+        }
+    }
+
+    const std::string header = "-s" + std::to_string((int) sampleRate) + " -xi16\n";
+
+    std::vector<float> drain_ms(nStreams);
+    std::atomic<int> nHalfSent(0);
+    std::atomic<int> nFailed(0);
+    std::atomic<int> nDecoded(0);
+    double audio_s = 0.0;
+
+    const auto tStart = Clock::now();
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < nStreams; ++i) {
+        audio_s += waveforms[i].size()/sampleRate;
+
+        clients.emplace_back([&, i]() {
+            const int fd = openSocket(address, false);
+            if (fd < 0) {
+                ++nFailed;
+                ++nHalfSent;
+                return;
+            }
+
+            sendAll(fd, header.data(), header.size());
+
+            // 20 ms chunks, at the pace of the sample rate in real-time mode
+            const auto & waveform = waveforms[i];
+            const int nChunk = 0.02f*sampleRate;
+            const auto tStream = Clock::now();
+            for (int k = 0; k < (int) waveform.size(); k += nChunk) {
+                if (isRealTime) {
+                    std::this_thread::sleep_until(tStream + std::chrono::microseconds((int64_t) (1e6*k/sampleRate)));
+                }
+
+                sendAll(fd, waveform.data() + k, std::min<int>(nChunk, waveform.size() - k)*sizeof(int16_t));
+
+                if (k < (int) waveform.size()/2 && k + nChunk >= (int) waveform.size()/2) {
+                    ++nHalfSent;
+                }
+            }
+
+            // the rest of the text arrives after the end of the stream
+            shutdown(fd, SHUT_WR);
+
+            const auto tDrain = Clock::now();
+
+            std::string text;
+            char buffer[1024];
+            ssize_t n = 0;
+            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                text.append(buffer, n);
+            }
+            close(fd);
+
+            drain_ms[i] = getTime_ms(tDrain, Clock::now());
+
+            if (text.find("DE " + callsigns[i] + " K") != std::string::npos) {
+                ++nDecoded;
+            }
+        });
+    }
+
+    // the server counters in the middle of the test
+    while (nHalfSent < nStreams) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::string stats;
+    {
+        const int fd = openSocket(address, false);
+        if (fd >= 0) {
+            sendAll(fd, "stats\n", 6);
+
+            char buffer[4096];
+            ssize_t n = 0;
+            while ((n = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+                stats.append(buffer, n);
+            }
+            close(fd);
+        }
+    }
+
+    for (auto & client : clients) {
+        client.join();
+    }
+
+    const float total_s = 1e-3f*getTime_ms(tStart, Clock::now());
+
+    // summary of the per-stream counters
+    float rtfMax = 0.0f;
+    float backlogMax_ms = 0.0f;
+    int nStats = 0;
+    {
+        size_t pos = stats.find('\n');
+        while (pos != std::string::npos && pos + 1 < stats.size()) {
+            int id = 0;
+            float rate = 0.0f, audio = 0.0f, wall = 0.0f, rtf = 0.0f, backlog_ms = 0.0f;
+            if (sscanf(stats.c_str() + pos + 1, "%d %f %f %f %f %f", &id, &rate, &audio, &wall, &rtf, &backlog_ms) == 6) {
+                rtfMax = std::max(rtfMax, rtf);
+                backlogMax_ms = std::max(backlogMax_ms, backlog_ms);
+                ++nStats;
+            }
+            pos = stats.find('\n', pos + 1);
+        }
+    }
+
+    std::sort(drain_ms.begin(), drain_ms.end());
+
+    printf("Streams:     %d, %d failed, %d decoded the message\n", nStreams, nFailed.load(), nDecoded.load());
+    printf("Audio:       %.1f s in %.2f s - %.1f s of audio per second\n", audio_s, total_s, audio_s/total_s);
+    printf("Mid-test:    %d streams, max RTF %.4f, max backlog %.1f ms\n", nStats, rtfMax, backlogMax_ms);
+    printf("Drain:       p50 %.2f ms, p99 %.2f ms - from the end of a stream to the last of its text\n",
+           drain_ms[nStreams/2], drain_ms[std::min(nStreams - 1, (99*nStreams)/100)]);
+
+    return nFailed > 0 ? -6 : 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    fprintf(stderr, "Usage: %s [-uS] [-pN] [-tN] [-lN] [-dN] [-sN] [-r]\n", argv[0]);
+    fprintf(stderr, "    -uS - listen on the UNIX socket S\n");
+    fprintf(stderr, "    -pN - listen on the TCP port N of the loopback interface\n");
+    fprintf(stderr, "    -tN - number of worker threads, (default: number of hardware threads)\n");
+    fprintf(stderr, "    -lN - load generator - send N concurrent streams to the server at -u or -p, (default: off)\n");
+    fprintf(stderr, "    -dN - load generator - duration of each stream in seconds, (default: 30)\n");
+    fprintf(stderr, "    -sN - load generator - sample rate of the streams, (default: 8000)\n");
+    fprintf(stderr, "    -r  - load generator - send the streams in real time instead of as fast as possible\n");
+    fprintf(stderr, "\n");
+
+    auto argm = parseCmdArguments(argc, argv);
+
+    if (argm.find("h") != argm.end()) {
+        return 0;
+    }
+
+    Address address;
+    address.path = argm["u"];
+    address.port = argm["p"].empty() ? 0 : std::stoi(argm["p"]);
+
+    if (address.path.empty() && address.port <= 0) {
+        fprintf(stderr, "Specify the address with -u or -p\n");
+        return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    const int nStreams = argm["l"].empty() ? 0 : std::stoi(argm["l"]);
+    if (nStreams > 0) {
+        const float duration_s = argm["d"].empty() ? 30.0f : std::stof(argm["d"]);
+        const float sampleRate = argm["s"].empty() ? 8000.0f : std::stof(argm["s"]);
+
+        if (duration_s <= 0.0f || sampleRate < 1000.0f || sampleRate > 192000.0f) {
+            fprintf(stderr, "Invalid duration or sample rate\n");
+            return -1;
+        }
+
+        return runLoadTest(address, nStreams, duration_s, sampleRate, argm.find("r") != argm.end());
+    }
+
+    const int nThreads = argm["t"].empty() ? std::max(1, (int) std::thread::hardware_concurrency()) : std::stoi(argm["t"]);
+    if (nThreads < 1) {
+        fprintf(stderr, "Invalid number of threads\n");
+        return -1;
+    }
+
+    Server server;
+
+    return server.run(address, nThreads);
+}
@@ -1,59 +1,49 @@
 <?php
 
-$cmd = "ggmorse-to-file";
+// requests are served by a running "ggmorse-to-file -u/tmp/ggmorse-to-file.sock" instead of a new process each
+$socket = "unix:///tmp/ggmorse-to-file.sock";
 
-if (isset($_GET['s'])) { $cmd .= " -s".intval($_GET['s']); }
-if (isset($_GET['v'])) { $cmd .= " -v".intval($_GET['v']); }
-if (isset($_GET['f'])) { $cmd .= " -f".intval($_GET['f']); }
-if (isset($_GET['w'])) { $cmd .= " -w".intval($_GET['w']); }
+$request = "";
 
-$descriptorspec = array(
-    0 => array("pipe", "r"),
-    //1 => array("pipe", "w"),
-    2 => array("pipe", "w"),
-);
+if (isset($_GET['s'])) { $request .= "-s".intval($_GET['s'])." "; }
+if (isset($_GET['v'])) { $request .= "-v".intval($_GET['v'])." "; }
+if (isset($_GET['f'])) { $request .= "-f".intval($_GET['f'])." "; }
+if (isset($_GET['w'])) { $request .= "-w".intval($_GET['w'])." "; }
 
-$path_wav = tempnam("/tmp", "ggmorse");
+$message = isset($_GET['m']) ? str_replace(array("\r", "\n"), " ", $_GET['m']) : "";
 
-$cmd .= " > $path_wav";
+$request .= "\n".$message."\n";
 
-$process = proc_open($cmd, $descriptorspec, $pipes);
+$stream = stream_socket_client($socket, $errno, $errstr, 5);
 
-if (is_resource($process)) {
-    $message = $_GET['m'];
-
-    fwrite($pipes[0], $message);
-    fclose($pipes[0]);
-
-    //$result = stream_get_contents($pipes[1]);
-    //fclose($pipes[1]);
-
-    $log = stream_get_contents($pipes[2]);
-    fclose($pipes[2]);
+if ($stream === false) {
+    header('Content-type: text/plain');
+    echo "Service unavailable: $errstr\n";
+    exit;
+}
 
-    $return_value = proc_close($process);
+fwrite($stream, $request);
 
-    //exec("ffmpeg -i ".$path_wav." ".$path_wav);
+// the WAV header is sent first - it starts with "RIFF" and holds the size of the data
+$header = fread($stream, 44);
 
-    $result = file_get_contents($path_wav);
-    $size = filesize($path_wav);
+if (strlen($header) < 44 || substr($header, 0, 4) != "RIFF") {
+    header('Content-type: text/plain');
+    echo $header.stream_get_contents($stream);
+} else {
+    $size = 8 + unpack("V", substr($header, 4, 4))[1];
 
-    if ($size == 0) {
-        header('Content-type: text/plain');
-        echo $log;
-    } else {
-        //header("Content-Type: audio/wav");
-        header("Content-Type: ". mime_content_type($path_wav));
-        header("Content-Length: $size");
-        header("Accept-Ranges: bytes");
-        header('Content-Disposition: attachment; filename="output.wav"');
-        header("Content-Transfer-Encoding: binary");
-        header("Content-Range: bytes 0-".$size."/".$size);
+    header("Content-Type: audio/x-wav");
+    header("Content-Length: $size");
+    header("Accept-Ranges: bytes");
+    header('Content-Disposition: attachment; filename="output.wav"');
+    header("Content-Transfer-Encoding: binary");
+    header("Content-Range: bytes 0-".$size."/".$size);
 
-        echo $result;
-    }
+    echo $header;
+    fpassthru($stream);
 }
 
-unlink($path_wav);
+fclose($stream);
 
 ?>
@@ -5,16 +5,425 @@
 
 #include "ggmorse-common.h"
 
+// the server mode and the load test use POSIX sockets - they are not available on Windows
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// limits of the server mode - the requests can come from the public HTTP front-end
+constexpr int kMaxOptionsSize = 256;
+constexpr int kMaxMessageSize = 256;
+constexpr int kMaxRequestSize = kMaxOptionsSize + kMaxMessageSize + 4;
+constexpr uint32_t kMaxWaveformSize = 32*1024*1024;
+
+// warm encoders kept by each server thread, one per output sample rate
+constexpr int kMaxEncodersPerThread = 8;
+
+struct Options {
+    float frequency_hz = 550.0f;
+    float speed_wpm = 25.0f;
+    int volume = 50;
+    float sampleRateOut = GGMorse::kBaseSampleRate;
+};
+
+// returns an empty string if the options are valid, otherwise the reason why they are not
+std::string parseOptions(std::map<std::string, std::string> argm, Options & options) {
+    try {
+        if (argm["f"].empty() == false) options.frequency_hz = std::stof(argm["f"]);
+        if (argm["w"].empty() == false) options.speed_wpm = std::stof(argm["w"]);
+        if (argm["v"].empty() == false) options.volume = std::stoi(argm["v"]);
+        if (argm["s"].empty() == false) options.sampleRateOut = std::stof(argm["s"]);
+    } catch (...) {
+        return "Invalid option";
+    }
+
+    if (options.frequency_hz < 100 || options.frequency_hz > options.sampleRateOut/2 + 1) {
+        return "Invalid frequency";
+    }
+
+    if (options.speed_wpm < 5 || options.speed_wpm > 140) {
+        return "Invalid speed";
+    }
+
+    if (options.volume <= 0 || options.volume > 100) {
+        return "Invalid volume";
+    }
+
+    if (options.sampleRateOut < 4000 || options.sampleRateOut > 96000) {
+        return "Invalid sample rate: " + std::to_string(options.sampleRateOut);
+    }
+
+    return "";
+}
+
+GGMorse::Parameters getParameters(float sampleRateOut) {
+    auto parameters = GGMorse::getDefaultParameters();
+    parameters.sampleRateOut = sampleRateOut;
+    parameters.sampleFormatOut = GGMORSE_SAMPLE_FORMAT_I16;
+
+    return parameters;
+}
+
+void initEncoder(GGMorseEncoder & ggMorse, const Options & options, const std::string & message) {
+    ggMorse.setParametersEncode({ 0.01f*options.volume, options.frequency_hz, options.speed_wpm, options.speed_wpm, false });
+    ggMorse.init(message.size(), message.data());
+}
+
+// write the WAV file of the message the encoder was initialized with - returns the number of frames written
+// the size is known in advance, so the WAV header is written first and the output does not need to be seekable
+drwav_uint64 writeWav(GGMorseEncoder & ggMorse, const Options & options, drwav_write_proc onWrite, void * userData) {
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_PCM;
+    format.channels = 1;
+    format.sampleRate = options.sampleRateOut;
+    format.bitsPerSample = 16;
+
+    // 0 if the waveform does not fit in a WAV file
+    const uint32_t nSamples = ggMorse.encodeSize_samples();
+    if (nSamples == 0) {
+        return 0;
+    }
+
+    drwav wav;
+    if (drwav_init_write_sequential_pcm_frames(&wav, &format, nSamples, onWrite, userData, NULL) == false) {
+        return 0;
+    }
+
+    // the waveform is generated and written one chunk at a time
+    int16_t bufferPCM[8*1024];
+    drwav_uint64 framesWritten = 0;
+    while (ggMorse.hasTxData()) {
+        const uint32_t nBytes = ggMorse.encode(bufferPCM, sizeof(bufferPCM));
+        const drwav_uint64 nFrames = drwav_write_pcm_frames(&wav, nBytes/2, bufferPCM);
+        framesWritten += nFrames;
+
+        if (nFrames < nBytes/2) {
+            break;
+        }
+    }
+
+    drwav_uninit(&wav);
+
+    return framesWritten;
+}
+
+size_t writeFile(void * userData, const void * data, size_t nBytes) {
+    return fwrite(data, 1, nBytes, (FILE *) userData);
+}
+
+#ifndef _WIN32
+
+// without MSG_NOSIGNAL (macOS), SIGPIPE is ignored for the whole process instead - see main()
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+size_t writeSocket(void * userData, const void * data, size_t nBytes) {
+    const int fd = *(const int *) userData;
+
+    size_t nSent = 0;
+    while (nSent < nBytes) {
+        const ssize_t n = send(fd, (const char *) data + nSent, nBytes - nSent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        nSent += n;
+    }
+
+    return nSent;
+}
+
+//
+// server mode
+//
+
+struct Address {
+    std::string path;   // UNIX socket
+    int port = 0;       // TCP port on the loopback interface
+};
+
+int openSocket(const Address & address, bool isServer) {
+    const int fd = socket(address.path.empty() ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    sockaddr_un addrUnix = {};
+    sockaddr_in addrInet = {};
+    sockaddr * addr = nullptr;
+    socklen_t addrSize = 0;
+
+    if (address.path.empty() == false) {
+        if (address.path.size() >= sizeof(addrUnix.sun_path)) {
+            close(fd);
+            return -1;
+        }
+
+        addrUnix.sun_family = AF_UNIX;
+        strcpy(addrUnix.sun_path, address.path.c_str());
+        addr = (sockaddr *) &addrUnix;
+        addrSize = sizeof(addrUnix);
+    } else {
+        addrInet.sin_family = AF_INET;
+        addrInet.sin_port = htons(address.port);
+        addrInet.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr = (sockaddr *) &addrInet;
+        addrSize = sizeof(addrInet);
+    }
+
+    if (isServer) {
+        if (address.path.empty() == false) {
+            unlink(address.path.c_str());
+        } else {
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        }
+
+        if (bind(fd, addr, addrSize) != 0 || listen(fd, 128) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else if (connect(fd, addr, addrSize) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+// read the request - a line with the options, for example "-s8000 -w35", followed by a line with the message
+// the message is taken as it is, so it can start with '-' and it cannot change the options
+// returns an empty string if the request is valid, otherwise the reason why it is not
+std::string readRequest(int fd, std::map<std::string, std::string> & argm, std::string & message) {
+    std::string request;
+
+    char buffer[1024];
+    while (std::count(request.begin(), request.end(), '\n') < 2 && (int) request.size() < kMaxRequestSize) {
+        const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, n);
+    }
+
+    const size_t endOptions = request.find('\n');
+    if (endOptions == std::string::npos || endOptions > kMaxOptionsSize) {
+        return "Invalid options";
+    }
+
+    const size_t endMessage = request.find('\n', endOptions + 1);
+    if (endMessage == std::string::npos) {
+        return (int) request.size() >= kMaxRequestSize ? "Message too long" : "Invalid message: size = 0";
+    }
+
+    std::string options = request.substr(0, endOptions);
+    message = request.substr(endOptions + 1, endMessage - endOptions - 1);
+
+    for (auto line : { &options, &message }) {
+        if (line->empty() == false && line->back() == '\r') {
+            line->pop_back();
+        }
+    }
+
+    if (message.empty()) {
+        return "Invalid message: size = 0";
+    }
+
+    if ((int) message.size() > kMaxMessageSize) {
+        return "Message too long";
+    }
+
+    size_t pos = 0;
+    while (pos < options.size()) {
+        const size_t end = std::min(options.find(' ', pos), options.size());
+        if (end > pos) {
+            if (options[pos] != '-' || end - pos < 2) {
+                return "Invalid option";
+            }
+            argm[std::string(1, options[pos + 1])] = options.substr(pos + 2, end - pos - 2);
+        }
+        pos = end + 1;
+    }
+
+    return "";
+}
+
+void serve(int fd, std::map<float, std::unique_ptr<GGMorseEncoder>> & encoders) {
+    std::map<std::string, std::string> argm;
+    std::string message;
+
+    Options options;
+    std::string error = readRequest(fd, argm, message);
+    if (error.empty()) {
+        error = parseOptions(argm, options);
+    }
+
+    if (error.empty()) {
+        auto it = encoders.find(options.sampleRateOut);
+        if (it == encoders.end()) {
+            if ((int) encoders.size() == kMaxEncodersPerThread) {
+                encoders.clear();
+            }
+
+            it = encoders.emplace(options.sampleRateOut, std::unique_ptr<GGMorseEncoder>(new GGMorseEncoder(getParameters(options.sampleRateOut)))).first;
+        }
+
+        auto & encoder = *it->second;
+        initEncoder(encoder, options, message);
+
+        const uint32_t nBytes = encoder.encodeSize_bytes();
+        if (nBytes == 0 || nBytes > kMaxWaveformSize) {
+            error = "Waveform too long";
+        } else if (writeWav(encoder, options, writeSocket, &fd) == 0) {
+            error = "Failed to generate waveform!";
+        }
+    }
+
+    if (error.empty() == false) {
+        error = "ERROR: " + error + "\n";
+        writeSocket(&fd, error.data(), error.size());
+    }
+}
+
+int runServer(const Address & address, int nThreads) {
+    const int fd = openSocket(address, true);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to listen on %s\n", address.path.empty() ? std::to_string(address.port).c_str() : address.path.c_str());
+        return -5;
+    }
+
+    fprintf(stderr, "Listening on %s with %d threads ...\n", address.path.empty() ? std::to_string(address.port).c_str() : address.path.c_str(), nThreads);
+
+    // every thread accepts and serves one connection at a time, with its own warm encoders
+    std::vector<std::thread> workers;
+    for (int i = 0; i < nThreads; ++i) {
+        workers.emplace_back([fd]() {
+            std::map<float, std::unique_ptr<GGMorseEncoder>> encoders;
+
+            while (true) {
+                const int fdClient = accept(fd, nullptr, nullptr);
+                if (fdClient < 0) {
+                    continue;
+                }
+
+                timeval timeout = { 10, 0 };
+                setsockopt(fdClient, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                setsockopt(fdClient, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+                serve(fdClient, encoders);
+
+                close(fdClient);
+            }
+        });
+    }
+
+    for (auto & worker : workers) {
+        worker.join();
+    }
+
+    return 0;
+}
+
+// send nRequests requests over nConnections concurrent connections and report the throughput and the latency
+int runLoadTest(const Address & address, const std::string & request, int nRequests, int nConnections) {
+    std::vector<float> latency_ms(nRequests);
+    std::atomic<int> nextRequest(0);
+    std::atomic<int> nErrors(0);
+    std::atomic<int64_t> nBytesTotal(0);
+
+    const auto tStart = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> clients;
+    for (int i = 0; i < nConnections; ++i) {
+        clients.emplace_back([&]() {
+            std::vector<char> buffer(64*1024);
+
+            int iRequest = 0;
+            while ((iRequest = nextRequest++) < nRequests) {
+                const auto tRequest = std::chrono::high_resolution_clock::now();
+
+                int64_t nBytes = 0;
+                bool isWav = false;
+
+                const int fd = openSocket(address, false);
+                if (fd >= 0) {
+                    writeSocket((void *) &fd, request.data(), request.size());
+
+                    ssize_t n = 0;
+                    while ((n = recv(fd, buffer.data(), buffer.size(), 0)) > 0) {
+                        isWav = isWav || (nBytes == 0 && n >= 4 && memcmp(buffer.data(), "RIFF", 4) == 0);
+                        nBytes += n;
+                    }
+
+                    close(fd);
+                }
+
+                latency_ms[iRequest] = getTime_ms(tRequest, std::chrono::high_resolution_clock::now());
+
+                if (isWav == false) {
+                    ++nErrors;
+                }
+                nBytesTotal += nBytes;
+            }
+        });
+    }
+
+    for (auto & client : clients) {
+        client.join();
+    }
+
+    const float total_s = 1e-3f*getTime_ms(tStart, std::chrono::high_resolution_clock::now());
+
+    std::sort(latency_ms.begin(), latency_ms.end());
+
+    printf("Requests:    %d, %d failed, %d connections\n", nRequests, nErrors.load(), nConnections);
+    printf("Throughput:  %.1f requests/s, %.2f MB/s\n", nRequests/total_s, 1e-6*nBytesTotal/total_s);
+    printf("Latency:     p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           latency_ms[nRequests/2], latency_ms[std::min(nRequests - 1, (99*nRequests)/100)], latency_ms.back());
+
+    return nErrors > 0 ? -6 : 0;
+}
+
+#endif
+
+}
 
 int main(int argc, char** argv) {
+#ifndef _WIN32
+    fprintf(stderr, "Usage: %s [-fN] [-wN] [-vN] [-sN] [-uS] [-pN] [-tN] [-lN] [-cN]\n", argv[0]);
+#else
     fprintf(stderr, "Usage: %s [-fN] [-wN] [-vN] [-sN]\n", argv[0]);
+#endif
     fprintf(stderr, "    -fN - frequency of the generated signal, N in [100, sampleRate/2], (default: 550)\n");
     fprintf(stderr, "    -wN - speed of the transmission in words-per-minute, N in [5, 140], (default: 25)\n");
     fprintf(stderr, "    -vN - output volume, N in (0, 100], (default: 50)\n");
     fprintf(stderr, "    -sN - output sample rate, N in [%d, %d], (default: %d)\n", (int) 4000, (int) 96000, (int) GGMorse::kBaseSampleRate);
+#ifndef _WIN32
+    fprintf(stderr, "    -uS - server mode - listen on the UNIX socket S\n");
+    fprintf(stderr, "    -pN - server mode - listen on the TCP port N of the loopback interface\n");
+    fprintf(stderr, "    -tN - number of server threads, (default: number of hardware threads)\n");
+    fprintf(stderr, "    -lN - load test - send N requests to the server at -u or -p, (default: off)\n");
+    fprintf(stderr, "    -cN - number of concurrent connections of the load test, (default: 8)\n");
+#endif
     fprintf(stderr, "\n");
 
     if (argc < 1) {
@@ -27,29 +436,34 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    float frequency_hz = argm["f"].empty() ? 550.0f : std::stof(argm["f"]);
-    float speed_wpm = argm["w"].empty() ? 25.0f : std::stof(argm["w"]);
-    int volume = argm["v"].empty() ? 50 : std::stoi(argm["v"]);
-    float sampleRateOut = argm["s"].empty() ? GGMorse::kBaseSampleRate : std::stof(argm["s"]);
+#ifndef _WIN32
+    Address address;
+    address.path = argm["u"];
+    address.port = argm["p"].empty() ? 0 : std::stoi(argm["p"]);
 
-    if (frequency_hz < 100 || frequency_hz > sampleRateOut/2 + 1) {
-        fprintf(stderr, "Invalid frequency\n");
-        return -1;
-    }
+    const bool isNetwork = address.path.empty() == false || address.port > 0;
+    const int nLoadTest = argm["l"].empty() ? 0 : std::stoi(argm["l"]);
 
-    if (speed_wpm < 5 || speed_wpm > 140) {
-        fprintf(stderr, "Invalid speed\n");
-        return -1;
-    }
+    if (isNetwork && nLoadTest == 0) {
+        const int nThreads = argm["t"].empty() ? std::max(1, (int) std::thread::hardware_concurrency()) : std::stoi(argm["t"]);
+        if (nThreads < 1) {
+            fprintf(stderr, "Invalid number of threads\n");
+            return -1;
+        }
 
-    if (volume <= 0 || volume > 100) {
-        fprintf(stderr, "Invalid volume\n");
-        return -1;
+        signal(SIGPIPE, SIG_IGN);
+
+        return runServer(address, nThreads);
     }
+#endif
 
-    if (sampleRateOut < 4000 || sampleRateOut > 96000) {
-        fprintf(stderr, "Invalid sample rate: %g\n", sampleRateOut);
-        return -1;
+    Options options;
+    {
+        const auto error = parseOptions(argm, options);
+        if (error.empty() == false) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return -1;
+        }
     }
 
     fprintf(stderr, "Enter a text message:\n");
@@ -62,47 +476,45 @@ int main(int argc, char** argv) {
         return -2;
     }
 
-    if (message.size() > 256) {
-        fprintf(stderr, "Invalid message: size > 256\n");
-        return -3;
+#ifndef _WIN32
+    if (nLoadTest > 0) {
+        const int nConnections = argm["c"].empty() ? 8 : std::stoi(argm["c"]);
+        if (isNetwork == false || nConnections < 1) {
+            fprintf(stderr, "The load test needs a server address and at least one connection\n");
+            return -1;
+        }
+
+        // the same options as on the command line
+        std::string request;
+        for (const auto & option : { "f", "w", "v", "s" }) {
+            if (argm[option].empty() == false) {
+                request += std::string("-") + option + argm[option] + " ";
+            }
+        }
+        request += "\n" + message + "\n";
+
+        signal(SIGPIPE, SIG_IGN);
+
+        return runLoadTest(address, request, nLoadTest, nConnections);
     }
+#endif
 
     fprintf(stderr, "Generating waveform for message '%s' ...\n", message.c_str());
 
-    GGMorse ggMorse({ GGMorse::kBaseSampleRate, sampleRateOut, GGMorse::kDefaultSamplesPerFrame, GGMORSE_SAMPLE_FORMAT_F32, GGMORSE_SAMPLE_FORMAT_I16 });
+    GGMorseEncoder ggMorse(getParameters(options.sampleRateOut));
 
-    ggMorse.setParametersEncode({ 0.01f*volume, frequency_hz, speed_wpm, speed_wpm });
-    ggMorse.init(message.size(), message.data());
+    fprintf(stderr, "Writing WAV data ...\n");
 
-    std::vector<char> bufferPCM;
-    GGMorse::CBWaveformOut cbWaveformOut = [&](const void * data, uint32_t nBytes) {
-        bufferPCM.resize(nBytes);
-        std::memcpy(bufferPCM.data(), data, nBytes);
-    };
+    initEncoder(ggMorse, options, message);
 
-    if (ggMorse.encode(cbWaveformOut) == false) {
+    const drwav_uint64 framesWritten = writeWav(ggMorse, options, writeFile, stdout);
+
+    if (framesWritten == 0) {
         fprintf(stderr, "Failed to generate waveform!\n");
         return -4;
     }
 
-    fprintf(stderr, "Output size = %d bytes\n", (int) bufferPCM.size());
-
-    drwav_data_format format;
-    format.container = drwav_container_riff;
-    format.format = DR_WAVE_FORMAT_PCM;
-    format.channels = 1;
-    format.sampleRate = sampleRateOut;
-    format.bitsPerSample = 16;
-
-    fprintf(stderr, "Writing WAV data ...\n");
-
-    drwav wav;
-    drwav_init_file_write(&wav, "/dev/stdout", &format, NULL);
-    drwav_uint64 framesWritten = drwav_write_pcm_frames(&wav, bufferPCM.size()/2, bufferPCM.data());
-
     fprintf(stderr, "WAV frames written = %d\n", (int) framesWritten);
 
-    drwav_uninit(&wav);
-
     return 0;
 }
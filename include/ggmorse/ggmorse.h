@@ -31,16 +31,44 @@ extern "C" {
         GGMORSE_SAMPLE_FORMAT_U16,
         GGMORSE_SAMPLE_FORMAT_I16,
         GGMORSE_SAMPLE_FORMAT_F32,
+        GGMORSE_SAMPLE_FORMAT_I24,              // packed, 3 bytes per sample
+        GGMORSE_SAMPLE_FORMAT_I32,
+        GGMORSE_SAMPLE_FORMAT_F64,
     } ggmorse_SampleFormat;
 
+    // How the channels of multi-channel captured audio are decoded
+    typedef enum {
+        GGMORSE_CHANNEL_MODE_SELECT,            // decode only the channel selected by channelInp
+        GGMORSE_CHANNEL_MODE_DOWNMIX,           // decode the average of all channels
+        GGMORSE_CHANNEL_MODE_INDEPENDENT,       // decode each channel with its own decoder
+    } ggmorse_ChannelMode;
+
+    // Kind of the captured signal
+    typedef enum {
+        GGMORSE_INPUT_MODE_AUDIO,               // real audio samples with an audible CW tone
+        GGMORSE_INPUT_MODE_IQ,                  // complex baseband - interleaved I and Q samples
+    } ggmorse_InputMode;
+
     typedef struct {
         float sampleRateInp;                    // capture sample rate
         float sampleRateOut;                    // playback sample rate
         int samplesPerFrame;                    // number of samples per audio frame
         ggmorse_SampleFormat sampleFormatInp;   // format of the captured audio samples
         ggmorse_SampleFormat sampleFormatOut;   // format of the playback audio samples
+        int channelsInp;                        // number of interleaved channels in the captured audio (0 - mono)
+        ggmorse_ChannelMode channelModeInp;     // how the captured channels are decoded
+        int channelInp;                         // channel to decode in GGMORSE_CHANNEL_MODE_SELECT
+        ggmorse_InputMode inputModeInp;         // kind of the captured signal
+        float carrierInp_hz;                    // offset of the CW carrier in the I/Q baseband, can be negative
     } ggmorse_Parameters;
 
+    // Detector of the tone envelope in the audio input
+    typedef enum {
+        GGMORSE_TONE_DETECTOR_GOERTZEL,         // running Goertzel filter, evaluated for every sample
+        GGMORSE_TONE_DETECTOR_NCO,              // NCO mixer and CIC decimator, evaluated at the analysis rate
+        GGMORSE_TONE_DETECTOR_FLL,              // NCO detector with a frequency-locked loop that follows a drifting tone
+    } ggmorse_ToneDetector;
+
     typedef struct {
         float frequency_hz;
         float speed_wpm;
@@ -49,6 +77,10 @@ extern "C" {
 
         bool applyFilterHighPass;
         bool applyFilterLowPass;
+
+        ggmorse_ToneDetector toneDetector;
+
+        bool skimmer;                           // decode every signal in the frequency range, see takeSkimmerData()
     } ggmorse_ParametersDecode;
 
     typedef struct {
@@ -56,6 +88,8 @@ extern "C" {
         float frequency_hz;
         float speedCharacters_wpm;
         float speedFarnsworth_wpm;
+
+        bool keepWaveformI16;                   // keep a 16-bit copy of the generated waveform, see takeTxWaveformI16()
     } ggmorse_ParametersEncode;
 
     typedef struct {
@@ -76,25 +110,35 @@ extern "C" {
 // C++ interface
 //
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include <functional>
 
-class GGMorse {
+class GGMorseEncoder;
+class GGMorseDecoder;
+
+// Constants and types shared by the encoder and the decoder
+class GGMorseCommon {
 public:
     static constexpr auto kBaseSampleRate = 4000.0f;
     static constexpr auto kDefaultSamplesPerFrame = 128;
     static constexpr auto kMaxSamplesPerFrame = 2048;
     static constexpr auto kDefaultVolume = 10;
     static constexpr auto kMaxWindowToAnalyze_s = 3.0f;
-    static constexpr auto kMaxTxLength = 256;
+    static constexpr auto kMaxChannels = 16;
+    static constexpr auto kMaxSkimmerSignals = 64;
 
     using Parameters        = ggmorse_Parameters;
     using ParametersDecode  = ggmorse_ParametersDecode;
     using ParametersEncode  = ggmorse_ParametersEncode;
     using Statistics        = ggmorse_Statistics;
     using SampleFormat      = ggmorse_SampleFormat;
+    using ChannelMode       = ggmorse_ChannelMode;
+    using InputMode         = ggmorse_InputMode;
+    using ToneDetector      = ggmorse_ToneDetector;
 
     using WaveformF   = std::vector<float>;
     using WaveformI16 = std::vector<int16_t>;
@@ -102,15 +146,255 @@ public:
     using Spectrogram = std::vector<std::vector<float>>;
     using SignalF     = std::vector<float>;
 
+    // Text received from one of the signals in skimmer mode
+    struct SkimmerData {
+        int id;                                 // unique for the lifetime of the instance
+        float frequency_hz;
+        float speed_wpm;
+        bool active;                            // false - the signal is gone and this is the rest of its text
+        TxRx rxData;
+    };
+
     using CBWaveformOut = std::function<void(const void * data, uint32_t nBytes)>;
     using CBWaveformInp = std::function<uint32_t(void * data, uint32_t nMaxBytes)>;
 
-    GGMorse(const Parameters & parameters);
-    ~GGMorse();
-
     static const Parameters & getDefaultParameters();
     static const ParametersDecode & getDefaultParametersDecode();
     static const ParametersEncode & getDefaultParametersEncode();
+};
+
+// Generates Morse Code audio
+//
+// Only the output fields of the parameters are used - sampleRateOut and sampleFormatOut.
+//
+class GGMorseEncoder : public GGMorseCommon {
+public:
+    GGMorseEncoder(const Parameters & parameters);
+    ~GGMorseEncoder();
+
+    bool init(int dataSize, const char * dataBuffer);
+
+    bool setParametersEncode(const ParametersEncode & parameters);
+
+    // Size of the waveform that encode() generates for the current message and encode parameters
+    //
+    // Computed from the timing of the symbols, without generating the waveform. Returns 0 if there is no message
+    // or if the size in bytes does not fit in 32 bits.
+    //
+    uint32_t encodeSize_bytes() const;
+    uint32_t encodeSize_samples() const;
+
+    // Generate the whole transmission
+    //
+    // The waveform is passed to the callback in chunks of fixed size, in the output sample format.
+    //
+    bool encode(const CBWaveformOut & cbWaveformOut);
+
+    // Generate the next samples of the transmission into the provided buffer
+    //
+    // Returns the number of bytes written - less than nMaxBytes only at the end of the transmission.
+    // The memory used does not depend on the length of the message. With a buffer of encodeSize_bytes(), the
+    // whole transmission is generated in one call.
+    //
+    uint32_t encode(void * data, uint32_t nMaxBytes);
+
+    // Add text to the end of the message being sent - starts a new message if none is being sent
+    //
+    // Returns false outside of keyer mode once the last character of the message has started to be sent - there is
+    // no pause after the last character, so nothing can follow it.
+    //
+    bool append(int dataSize, const char * dataBuffer);
+
+    // Live keyer mode
+    //
+    // The transmission does not end with the message - text can be appended at any time and the encoder sends
+    // silence while there is nothing to send, so encode(data, nMaxBytes) always fills the whole buffer. The delay
+    // from append() to the audio is at most one buffer. encode(cbWaveformOut) returns at the end of the text
+    // appended so far. Disabling the mode ends the transmission after the remaining text. GGMorse does not decode
+    // while the mode is enabled.
+    //
+    bool setKeyer(bool enabled);
+
+    // instance state
+    const bool & hasTxData() const;
+
+    const int & getSampleSizeBytesOut() const;
+    const float & getSampleRateOut() const;
+    const SampleFormat & getSampleFormatOut() const;
+
+    // The waveform generated since the last init() call, as 16-bit signed int
+    // Available only with ParametersEncode::keepWaveformI16 - it grows with the length of the message.
+    int takeTxWaveformI16(WaveformI16 & dst);
+
+    // Modify the Morse Code alphabet - see GGMorse::setCharacter()
+    bool setCharacter(const std::string & s01, char c);
+    bool setCharacter(const std::string & s01, const std::string & text);
+
+private:
+    // expand the next character of the message into symbols - returns false at the end of the transmission
+    bool encode_symbols();
+    // synthesize up to nSamples samples from the current position - returns the number of samples
+    int encode_samples(float * dst, int nSamples);
+
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Encodes batches of messages on a pool of worker threads
+//
+// Each thread has its own encoder, so the synthesis buffers and the element templates are reused across the
+// messages and the batches. Only the output fields of the parameters are used.
+//
+class GGMorseBatchEncoder : public GGMorseCommon {
+public:
+    struct Message {
+        std::string text;
+        ParametersEncode parameters;
+
+        void * output;                          // buffer for the waveform in the output sample format
+        uint32_t nMaxBytes;                     // size of the buffer - see encodeSize_bytes()
+        uint32_t nBytes;                        // size of the generated waveform, set by encode()
+    };
+
+    // nThreads - number of threads, including the one calling encode(), 0 - one per hardware thread
+    GGMorseBatchEncoder(const Parameters & parameters, int nThreads = 0);
+    ~GGMorseBatchEncoder();
+
+    // Size of the waveform of the message, 0 if it does not fit in 32 bits - see GGMorseEncoder::encodeSize_bytes()
+    //
+    // Can be called from any thread, also while encode() is running.
+    //
+    uint32_t encodeSize_bytes(const Message & message) const;
+
+    // Encode all messages into their output buffers, in parallel
+    //
+    // Returns false if a message has invalid parameters or does not fit in its buffer - the nBytes of such
+    // messages tell how much has been generated.
+    //
+    bool encode(std::vector<Message> & messages);
+
+    int getThreads() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Decodes Morse Code from captured audio or I/Q samples
+//
+// Only the input fields of the parameters are used.
+//
+class GGMorseDecoder : public GGMorseCommon {
+public:
+    GGMorseDecoder(const Parameters & parameters);
+    ~GGMorseDecoder();
+
+    bool setParametersDecode(const ParametersDecode & parameters);
+
+    bool decode(const CBWaveformInp & cbWaveformInp);
+
+    // Decode captured audio pushed by the caller
+    //
+    // The buffer can have any size. Complete frames are analyzed right away and the rest of the data is kept
+    // until the next call. Returns true if at least one frame was analyzed.
+    //
+    // Multi-channel audio is interleaved - all channels of the first sample, then all channels of the second
+    // sample and so on.
+    // I/Q input is interleaved the same way, with I first.
+    //
+    bool decode(const void * data, size_t nBytes);
+
+    // instance state
+    const bool & lastDecodeResult() const;
+
+    const int & getSamplesPerFrame() const;
+    const int & getSampleSizeBytesInp() const;
+
+    const float & getSampleRateInp() const;
+    const SampleFormat & getSampleFormatInp() const;
+    const int & getChannelsInp() const;
+
+    // In GGMORSE_CHANNEL_MODE_INDEPENDENT, each channel is decoded by a separate instance. The received data,
+    // the statistics and the spectrogram of a channel are available through its instance.
+    // Returns nullptr in the other channel modes.
+    GGMorseDecoder * getChannelDecoder(int channel);
+
+    const TxRx & getRxData() const;
+
+    int takeRxData(TxRx & dst);
+    int takeSignalF(SignalF & dst);
+
+    // In skimmer mode, every tone that stands out in the spectrum gets its own lightweight decoder, sharing the
+    // input front-end and the spectrum analysis of this instance. Decoders are started and stopped as signals
+    // come and go.
+    // Moves the text received since the last call into dst - one entry per signal with new text and one for every
+    // signal that has been stopped. Returns the number of entries.
+    // Skimmer mode is available for audio input only.
+    int takeSkimmerData(std::vector<SkimmerData> & dst);
+
+    const Statistics & getStatistics() const;
+    const Spectrogram getSpectrogram() const;
+
+    // Modify the Morse Code alphabet - see GGMorse::setCharacter()
+    bool setCharacter(const std::string & s01, char c);
+    bool setCharacter(const std::string & s01, const std::string & text);
+
+private:
+    bool decode_input(const void * data, size_t nSamples);
+    // analyze the next frame - if frame is nullptr, it has already been assembled in the history
+    void decode_frame(const float * frame);
+    void decode_baseband();
+    void decode_skimmer();
+    void decode_envelope(const SignalF & envelope, int nDownsample);
+
+    // the interval analysis of the tone envelope of one received signal
+    struct Receiver;
+    void decode_intervals(const SignalF & envelope, int nDownsample, Receiver & receiver);
+
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Decodes the captured audio of many decoders on a pool of worker threads
+//
+// Every frame of every decoder is a separate task. The frames of a decoder are decoded one at a time and in order,
+// and a thread that has no tasks left takes them from the other threads, so all threads stay busy even when some of
+// the decoders have much more work than others. The text and the other results are read from the decoders
+// themselves after wait().
+//
+// decode() and wait() are called from one thread. A decoder must not be used directly while it has queued audio.
+//
+class GGMorseDecoderPool : public GGMorseCommon {
+public:
+    // nThreads - number of worker threads, 0 - one per hardware thread
+    GGMorseDecoderPool(int nThreads = 0);
+    ~GGMorseDecoderPool();
+
+    // Queue captured audio for the decoder, as GGMorseDecoder::decode(data, nBytes) would take it
+    //
+    // The data is copied and the decoding starts right away.
+    //
+    bool decode(GGMorseDecoder & decoder, const void * data, size_t nBytes);
+
+    // Wait until all queued audio has been decoded
+    void wait();
+
+    int getThreads() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Encoder and decoder in one instance
+//
+// Decoding through the capture callback is paused while there is data to transmit.
+// Use GGMorseEncoder or GGMorseDecoder directly when only one of them is needed.
+//
+class GGMorse : public GGMorseCommon {
+public:
+    GGMorse(const Parameters & parameters);
+    ~GGMorse();
 
     bool init(int dataSize, const char * dataBuffer);
 
@@ -121,7 +405,11 @@ public:
     uint32_t encodeSize_samples() const;
 
     bool encode(const CBWaveformOut & cbWaveformOut);
+    uint32_t encode(void * data, uint32_t nMaxBytes);
+    bool append(int dataSize, const char * dataBuffer);
+    bool setKeyer(bool enabled);
     bool decode(const CBWaveformInp & cbWaveformInp);
+    bool decode(const void * data, size_t nBytes);
 
     // instance state
     const bool & hasTxData() const;
@@ -135,12 +423,16 @@ public:
     const float & getSampleRateOut() const;
     const SampleFormat & getSampleFormatInp() const;
     const SampleFormat & getSampleFormatOut() const;
+    const int & getChannelsInp() const;
+
+    GGMorseDecoder * getChannelDecoder(int channel);
 
     const TxRx & getRxData() const;
 
     int takeRxData(TxRx & dst);
     int takeSignalF(SignalF & dst);
     int takeTxWaveformI16(WaveformI16 & dst);
+    int takeSkimmerData(std::vector<SkimmerData> & dst);
 
     const Statistics & getStatistics() const;
     const Spectrogram getSpectrogram() const;
@@ -152,13 +444,19 @@ public:
     //
     // For example: setCharacter("01101", 'A') will set the character 'A' to the Morse Code sequence "01101"
     //
+    // The text of a sequence can also be up to 7 bytes long - a multi-byte UTF-8 character of a non-Latin
+    // alphabet or a prosign. For example: setCharacter("000101", "<SK>") or setCharacter("1111", "Ш").
+    // Sequences can be up to 9 dots and dashes long. Returns false if the sequence or the text is invalid.
+    //
     bool setCharacter(const std::string & s01, char c);
+    bool setCharacter(const std::string & s01, const std::string & text);
 
-private:
-    void decode_float();
+    GGMorseEncoder & encoder() { return *m_encoder; }
+    GGMorseDecoder & decoder() { return *m_decoder; }
 
-    struct Impl;
-    std::unique_ptr<Impl> m_impl;
+private:
+    std::unique_ptr<GGMorseEncoder> m_encoder;
+    std::unique_ptr<GGMorseDecoder> m_decoder;
 };
 
 #endif
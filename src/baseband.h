@@ -0,0 +1,421 @@
+#pragma once
+
+#include "ggmorse/ggmorse.h"
+
+#include "convert.h"
+#include "filter.h"
+#include "history.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Numerically controlled oscillator
+//
+// A unit phasor that is rotated by a fixed angle on every sample. The rotation is a complex multiplication,
+// so no trigonometric functions are evaluated per sample and retuning only changes the rotation step. The
+// magnitude of the phasor drifts slowly due to rounding and is pulled back to 1 after each block.
+//
+struct Nco {
+    void init(float frequency_hz, float sampleRate) {
+        m_re = 1.0f;
+        m_im = 0.0f;
+
+        setFrequency(frequency_hz, sampleRate);
+    }
+
+    // the phase is continuous across retuning
+    void setFrequency(float frequency_hz, float sampleRate) {
+        const double w = 2.0*pi*double(frequency_hz)/double(sampleRate);
+
+        m_stepRe = std::cos(w);
+        m_stepIm = std::sin(w);
+    }
+
+    // shift the spectrum of n complex samples (interleaved re, im) down by the oscillator frequency
+    void mixDown(float * iq, int n) {
+        float re = m_re;
+        float im = m_im;
+
+        for (int i = 0; i < n; ++i) {
+            const float x = iq[2*i + 0];
+            const float y = iq[2*i + 1];
+
+            iq[2*i + 0] = x*re + y*im;
+            iq[2*i + 1] = y*re - x*im;
+
+            const float t = re*m_stepRe - im*m_stepIm;
+            im = re*m_stepIm + im*m_stepRe;
+            re = t;
+        }
+
+        const float g = 1.5f - 0.5f*(re*re + im*im);
+        m_re = re*g;
+        m_im = im*g;
+    }
+
+    // same for n real samples - the output is complex (interleaved re, im)
+    void mixDown(const float * x, float * iq, int n) {
+        float re = m_re;
+        float im = m_im;
+
+        for (int i = 0; i < n; ++i) {
+            iq[2*i + 0] =  x[i]*re;
+            iq[2*i + 1] = -x[i]*im;
+
+            const float t = re*m_stepRe - im*m_stepIm;
+            im = re*m_stepIm + im*m_stepRe;
+            re = t;
+        }
+
+        const float g = 1.5f - 0.5f*(re*re + im*im);
+        m_re = re*g;
+        m_im = im*g;
+    }
+
+private:
+    float m_re = 1.0f;
+    float m_im = 0.0f;
+
+    float m_stepRe = 1.0f;
+    float m_stepIm = 0.0f;
+};
+
+// Input front-end of the decoder for complex baseband (I/Q) input
+//
+// The interleaved I/Q samples are converted to float and the carrier is mixed down to 0 Hz. The result is
+// averaged in blocks (integrate and dump) down to the base sample rate, where a complex low-pass filter sets
+// the detection bandwidth. Finally every kDownsample-th sample is reduced to its power - this is the envelope
+// that the interval analysis works on, at the rate at which it analyzes the audio envelope.
+//
+// The block boundaries are tracked with integer arithmetic in units of (input samples x base rate), so the
+// number of input samples needed for a given number of envelope samples is exact.
+//
+struct IQFrontEnd {
+    static constexpr int kChunkSize = 64;
+    static constexpr int kDownsample = 8;
+
+    // the rates are rounded to integers
+    void init(
+            ggmorse_SampleFormat sampleFormat,
+            int sampleSizeBytes,
+            float sampleRateInp,
+            float sampleRateBase,
+            float carrier_hz) {
+        m_sampleSizeBytes = sampleSizeBytes;
+        m_convert = convertToFloat(sampleFormat);
+
+        m_rateInp = std::lround(sampleRateInp);
+        m_rateBase = std::lround(sampleRateBase);
+        m_sampleRateBase = sampleRateBase;
+
+        m_nco.init(carrier_hz, sampleRateInp);
+
+        reset();
+    }
+
+    void initFilter(float bandwidth_hz, int order) {
+        m_filterLowPass.init(Filter::ButterworthLowPass, bandwidth_hz, m_sampleRateBase, order);
+    }
+
+    void reset() {
+        m_acc = 0;
+        m_count = 0;
+        m_sumRe = 0.0f;
+        m_sumIm = 0.0f;
+        m_skip = 0;
+
+        m_filterLowPass.reset();
+    }
+
+    // number of input samples that have to be processed to produce exactly nOut envelope samples
+    int nSamplesNeeded(int nOut) const {
+        if (nOut <= 0) return 0;
+
+        const int64_t nBase = m_skip + 1 + int64_t(nOut - 1)*kDownsample;
+
+        return int((nBase*m_rateInp - m_acc + m_rateBase - 1)/m_rateBase);
+    }
+
+    // process nInp I/Q input samples and write the produced envelope samples to dst
+    // returns the number of envelope samples
+    int process(const void * src, int nInp, float * dst) {
+        float iq[2*kChunkSize];
+        float base[2*kChunkSize];
+
+        int nOut = 0;
+        for (int i0 = 0; i0 < nInp; i0 += kChunkSize) {
+            const int n = std::min(kChunkSize, nInp - i0);
+
+            m_convert(reinterpret_cast<const uint8_t *>(src) + 2*i0*m_sampleSizeBytes, iq, 2*n);
+            m_nco.mixDown(iq, n);
+
+            // integrate and dump down to the base sample rate
+            int nBase = 0;
+            for (int i = 0; i < n; ++i) {
+                m_sumRe += iq[2*i + 0];
+                m_sumIm += iq[2*i + 1];
+                ++m_count;
+
+                m_acc += m_rateBase;
+                if (m_acc >= m_rateInp) {
+                    m_acc -= m_rateInp;
+
+                    const float scale = 1.0f/m_count;
+                    base[2*nBase + 0] = m_sumRe*scale;
+                    base[2*nBase + 1] = m_sumIm*scale;
+                    ++nBase;
+
+                    m_sumRe = 0.0f;
+                    m_sumIm = 0.0f;
+                    m_count = 0;
+                }
+            }
+
+            m_filterLowPass.process(base, nBase);
+
+            for (int i = m_skip; i < nBase; i += kDownsample) {
+                dst[nOut++] = base[2*i + 0]*base[2*i + 0] + base[2*i + 1]*base[2*i + 1];
+            }
+
+            // number of base-rate samples to skip from the next chunk
+            m_skip = (m_skip - nBase) % kDownsample;
+            if (m_skip < 0) m_skip += kDownsample;
+        }
+
+        return nOut;
+    }
+
+private:
+    int m_sampleSizeBytes = 0;
+    ConvertToFloat m_convert = nullptr;
+
+    int64_t m_rateInp = 1;
+    int64_t m_rateBase = 1;
+    float m_sampleRateBase = 1.0f;
+
+    int64_t m_acc = 0;
+    int m_count = 0;
+    float m_sumRe = 0.0f;
+    float m_sumIm = 0.0f;
+    int m_skip = 0;
+
+    Nco m_nco;
+    FilterLanes<2> m_filterLowPass;
+};
+
+// Tone envelope detector for real base-rate samples
+//
+// Alternative to the Goertzel filter: the tone is mixed down to 0 Hz and the result is decimated with a
+// cascaded integrator-comb (CIC) filter, so the envelope is produced directly at the rate of the interval
+// analysis instead of for every input sample. Per input sample this costs the mixer and a few integer
+// additions. Retuning only changes the phase increment of the NCO.
+//
+// The CIC runs on wrapping 32-bit integers, so the integrators never lose precision. The mixer output is
+// scaled to 16 bits and the filter gain is (kDecimation*kDelay)^kOrder = 2^12, which leaves headroom.
+//
+// With tracking enabled, a frequency-locked loop keeps the NCO on the tone: the phase rotation between two
+// consecutive envelope samples is the residual frequency offset, and a fraction of it is added to the NCO
+// frequency at every envelope sample. Only pairs of samples above the average power - the key-down parts of
+// the signal - update the loop, so the noise during the pauses does not pull it away.
+//
+struct ToneEnvelope {
+    static constexpr int kChunkSize = 64;
+
+    static constexpr int kOrder = 2;         // N
+    static constexpr int kDecimation = 8;    // R
+    static constexpr int kDelay = 8;         // M
+
+    static constexpr float kScale = 32768.0f;
+
+    // loop gain of the frequency tracking and smoothing factor of its power average, per envelope sample
+    static constexpr float kTrackingGain = 0.01f;
+    static constexpr float kTrackingAverage = 0.01f;
+
+    void init(float sampleRate, float history_s) {
+        m_sampleRate = sampleRate;
+
+        const int nFiltered = int(history_s*sampleRate)/kDecimation;
+
+        m_filtered.init(nFiltered, 0);
+        m_filteredOut.resize(nFiltered);
+
+        reset();
+    }
+
+    void setFrequency(float frequency_hz) {
+        m_frequency = frequency_hz;
+        m_nco.setFrequency(frequency_hz, m_sampleRate);
+    }
+
+    void setTracking(bool tracking) {
+        m_tracking = tracking;
+    }
+
+    // with tracking enabled, this is the frequency that the loop has locked to
+    float frequency() const { return m_frequency; }
+
+    void reset() {
+        m_phase = 0;
+        m_delayHead = 0;
+
+        m_prevRe = 0.0f;
+        m_prevIm = 0.0f;
+        m_prevPower = 0.0f;
+        m_powerAvg = 0.0f;
+
+        for (int k = 0; k < kOrder; ++k) {
+            m_integrator[k][0] = 0;
+            m_integrator[k][1] = 0;
+
+            for (int i = 0; i < kDelay; ++i) {
+                m_delay[k][i][0] = 0;
+                m_delay[k][i][1] = 0;
+            }
+        }
+    }
+
+    // the last n samples in the history are new
+    void process(const History & history, int n, float frequency_hz) {
+        setFrequency(frequency_hz);
+
+        float envelope[kChunkSize/kDecimation + 1];
+
+        // the new samples can wrap around the end of the ring
+        int idx = history.head() - n;
+        if (idx < 0) idx += history.size();
+
+        while (n > 0) {
+            const int len = std::min(std::min(n, history.size() - idx), kChunkSize);
+
+            m_filtered.push(envelope, process(history.view(idx), len, envelope));
+
+            idx += len;
+            if (idx >= history.size()) {
+                idx = 0;
+            }
+            n -= len;
+        }
+    }
+
+    // recompute the envelope for all samples in the history
+    void recompute(const History & history, float frequency_hz) {
+        reset();
+        m_filtered.clear();
+
+        process(history, history.size(), frequency_hz);
+    }
+
+    // the envelope, oldest sample first
+    const std::vector<float> & filtered() {
+        const int nf = m_filtered.size();
+        const int head = m_filtered.head();
+
+        std::copy(m_filtered.view(head), m_filtered.view(head) + (nf - head), m_filteredOut.begin());
+        std::copy(m_filtered.view(0), m_filtered.view(0) + head, m_filteredOut.begin() + (nf - head));
+
+        return m_filteredOut;
+    }
+
+private:
+    // returns the number of envelope samples written to dst - at most n/kDecimation + 1
+    int process(const float * samples, int n, float * dst) {
+        constexpr float kGain = 1.0f/(kScale*(kDecimation*kDelay)*(kDecimation*kDelay));
+
+        float iq[2*kChunkSize];
+
+        int nOut = 0;
+        for (int i0 = 0; i0 < n; i0 += kChunkSize) {
+            const int nChunk = std::min(kChunkSize, n - i0);
+
+            if (m_tracking) {
+                m_nco.setFrequency(m_frequency, m_sampleRate);
+            }
+
+            m_nco.mixDown(samples + i0, iq, nChunk);
+
+            for (int i = 0; i < nChunk; ++i) {
+                uint32_t x[2] = {
+                    uint32_t(int32_t(kScale*iq[2*i + 0])),
+                    uint32_t(int32_t(kScale*iq[2*i + 1])),
+                };
+
+                for (int k = 0; k < kOrder; ++k) {
+                    m_integrator[k][0] += x[0];
+                    m_integrator[k][1] += x[1];
+                    x[0] = m_integrator[k][0];
+                    x[1] = m_integrator[k][1];
+                }
+
+                if (++m_phase < kDecimation) {
+                    continue;
+                }
+                m_phase = 0;
+
+                for (int k = 0; k < kOrder; ++k) {
+                    auto & d = m_delay[k][m_delayHead];
+                    const uint32_t y[2] = { x[0] - d[0], x[1] - d[1] };
+                    d[0] = x[0];
+                    d[1] = x[1];
+                    x[0] = y[0];
+                    x[1] = y[1];
+                }
+
+                if (++m_delayHead >= kDelay) {
+                    m_delayHead = 0;
+                }
+
+                const float re = kGain*int32_t(x[0]);
+                const float im = kGain*int32_t(x[1]);
+                const float power = re*re + im*im;
+
+                if (m_tracking) {
+                    track(re, im, power);
+                }
+
+                dst[nOut++] = power;
+            }
+        }
+
+        return nOut;
+    }
+
+    void track(float re, float im, float power) {
+        m_powerAvg += kTrackingAverage*(power - m_powerAvg);
+
+        if (power > m_powerAvg && m_prevPower > m_powerAvg) {
+            // phase rotation since the previous envelope sample
+            const float dot = re*m_prevRe + im*m_prevIm;
+            const float cross = im*m_prevRe - re*m_prevIm;
+
+            const float error_hz = std::atan2(cross, dot)*(m_sampleRate/kDecimation)/(2.0*pi);
+
+            m_frequency = std::min(std::max(0.0f, m_frequency + kTrackingGain*error_hz), 0.5f*m_sampleRate);
+        }
+
+        m_prevRe = re;
+        m_prevIm = im;
+        m_prevPower = power;
+    }
+
+    float m_sampleRate = 1.0f;
+    float m_frequency = 0.0f;
+
+    bool m_tracking = false;
+    float m_prevRe = 0.0f;
+    float m_prevIm = 0.0f;
+    float m_prevPower = 0.0f;
+    float m_powerAvg = 0.0f;
+
+    int m_phase = 0;
+    int m_delayHead = 0;
+
+    uint32_t m_integrator[kOrder][2] = {};
+    uint32_t m_delay[kOrder][kDelay][2] = {};
+
+    Nco m_nco;
+
+    History m_filtered;
+    std::vector<float> m_filteredOut;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cstdint>
+
+// Morse Code alphabet for encoding and decoding
+//
+// A code is a sequence of up to kMaxElements dots and dashes, stored as bits - bit k is element k, 1 for a dash.
+// Decoding indexes a table with the code and its length, encoding indexes a table with the character, so both
+// directions take constant time and no memory is allocated.
+//
+// The text of a code is a short byte sequence - usually a single character, but it can also be a multi-byte
+// UTF-8 character of a non-Latin alphabet or a prosign like "<SK>". Texts of more than one byte are encoded by
+// matching them at the current position of the message.
+//
+struct Codebook {
+    static constexpr int kMaxElements = 9;
+    static constexpr int kMaxText = 7;
+    static constexpr int kMaxMultiByte = 64;
+
+    struct Code {
+        uint16_t bits = 0;
+        uint8_t length = 0;
+
+        // append a dot or a dash - codes longer than kMaxElements are kept only as too long
+        constexpr void push(bool isDash) {
+            if (length < kMaxElements) {
+                bits |= uint16_t(isDash) << length;
+            }
+            if (length <= kMaxElements) {
+                ++length;
+            }
+        }
+    };
+
+    struct Text {
+        uint8_t length = 0;
+        char data[kMaxText] = {};
+    };
+
+    // map the code s01 ("0" - dot, "1" - dash) to the text, in both directions
+    // the text loses its previous code and the code loses its previous text
+    // returns false if the code or the text is too long or empty
+    constexpr bool set(const char * s01, const char * text) {
+        Code code;
+        for (int k = 0; s01[k] != 0; ++k) {
+            if ((s01[k] != '0' && s01[k] != '1') || k == kMaxElements) {
+                return false;
+            }
+            code.push(s01[k] == '1');
+        }
+
+        Text value;
+        for (int k = 0; text[k] != 0; ++k) {
+            if (k == kMaxText) {
+                return false;
+            }
+            value.data[value.length++] = text[k];
+        }
+
+        if (code.length == 0 || value.length == 0) {
+            return false;
+        }
+
+        if (value.length > 1 && m_nMultiByte == kMaxMultiByte) {
+            bool isKnown = false;
+            for (int i = 0; i < m_nMultiByte; ++i) {
+                isKnown = isKnown || isSame(m_multiByte[i].text, value);
+            }
+            if (isKnown == false) {
+                return false;
+            }
+        }
+
+        erase(value);
+        erase(m_decode[index(code)]);
+
+        m_decode[index(code)] = value;
+
+        if (value.length == 1) {
+            m_encode[uint8_t(value.data[0])] = code;
+        } else {
+            m_multiByte[m_nMultiByte++] = { value, code };
+            m_hasMultiByte[uint8_t(toUpper(value.data[0]))] = true;
+        }
+
+        return true;
+    }
+
+    // text of the code - empty if the code is unknown
+    constexpr const Text & decode(const Code & code) const {
+        static_assert(sizeof(m_decode)/sizeof(m_decode[0]) == (2 << kMaxElements), "");
+        return code.length > kMaxElements ? m_decode[0] : m_decode[index(code)];
+    }
+
+    // code of the character at the start of the n bytes of data - empty if it has no code
+    // returns the number of bytes of the character
+    int encode(const uint8_t * data, int n, Code & code) const {
+        if (m_hasMultiByte[toUpper(data[0])]) {
+            for (int i = 0; i < m_nMultiByte; ++i) {
+                const auto & text = m_multiByte[i].text;
+                if (text.length > n) continue;
+
+                int k = 0;
+                while (k < text.length && toUpper(data[k]) == toUpper(text.data[k])) ++k;
+
+                if (k == text.length) {
+                    code = m_multiByte[i].code;
+                    return k;
+                }
+            }
+        }
+
+        code = m_encode[toUpper(data[0])];
+
+        return 1;
+    }
+
+private:
+    struct MultiByte {
+        Text text = {};
+        Code code = {};
+    };
+
+    static constexpr uint8_t toUpper(uint8_t c) {
+        return (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+    }
+
+    static constexpr int index(const Code & code) {
+        return (1 << code.length) | code.bits;
+    }
+
+    static constexpr bool isSame(const Text & a, const Text & b) {
+        if (a.length != b.length) return false;
+        for (int k = 0; k < a.length; ++k) {
+            if (a.data[k] != b.data[k]) return false;
+        }
+        return true;
+    }
+
+    // forget the code of the text in both directions
+    constexpr void erase(const Text & text) {
+        const Text value = text;
+
+        if (value.length == 1) {
+            Code & code = m_encode[uint8_t(value.data[0])];
+            if (code.length > 0) {
+                m_decode[index(code)] = {};
+                code = {};
+            }
+        } else if (value.length > 1) {
+            for (int i = 0; i < m_nMultiByte; ++i) {
+                if (isSame(m_multiByte[i].text, value)) {
+                    m_decode[index(m_multiByte[i].code)] = {};
+                    m_multiByte[i] = m_multiByte[--m_nMultiByte];
+                    break;
+                }
+            }
+
+            const uint8_t first = toUpper(value.data[0]);
+            m_hasMultiByte[first] = false;
+            for (int i = 0; i < m_nMultiByte; ++i) {
+                m_hasMultiByte[first] = m_hasMultiByte[first] || toUpper(m_multiByte[i].text.data[0]) == first;
+            }
+        }
+    }
+
+    Code m_encode[256] = {};
+    Text m_decode[2 << kMaxElements] = {};
+
+    int m_nMultiByte = 0;
+    bool m_hasMultiByte[256] = {};
+    MultiByte m_multiByte[kMaxMultiByte] = {};
+};
@@ -0,0 +1,528 @@
+#include "convert.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GGMORSE_CONVERT_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define GGMORSE_CONVERT_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+namespace {
+
+constexpr int kNumFormats = GGMORSE_SAMPLE_FORMAT_F64 + 1;
+
+constexpr float kScale8  = 1.0f/128;
+constexpr float kScale16 = 1.0f/32768;
+constexpr float kScale24 = 1.0f/8388608;
+constexpr float kScale32 = 1.0f/2147483648.0f;
+
+struct Kernels {
+    const char * name;
+
+    ConvertToFloat toFloat[kNumFormats];
+    ConvertFromFloat fromFloat[kNumFormats];
+};
+
+//
+// scalar
+//
+// the SIMD kernels use these for the samples that do not fill a whole register
+//
+
+void toFloatU8(const uint8_t * p, float * dst, int i, int n)  { for (; i < n; ++i) dst[i] = float(int(p[i]) - 128)*kScale8; }
+void toFloatI8(const int8_t * p, float * dst, int i, int n)   { for (; i < n; ++i) dst[i] = float(p[i])*kScale8; }
+void toFloatU16(const uint16_t * p, float * dst, int i, int n) { for (; i < n; ++i) dst[i] = float(int(p[i]) - 32768)*kScale16; }
+void toFloatI16(const int16_t * p, float * dst, int i, int n) { for (; i < n; ++i) dst[i] = float(p[i])*kScale16; }
+void toFloatI32(const int32_t * p, float * dst, int i, int n) { for (; i < n; ++i) dst[i] = float(p[i])*kScale32; }
+void toFloatF64(const double * p, float * dst, int i, int n)  { for (; i < n; ++i) dst[i] = float(p[i]); }
+
+void toFloatI24(const uint8_t * p, float * dst, int i, int n) {
+    for (; i < n; ++i) {
+        const uint32_t v = uint32_t(p[3*i + 0]) << 8 | uint32_t(p[3*i + 1]) << 16 | uint32_t(p[3*i + 2]) << 24;
+        dst[i] = float(int32_t(v) >> 8)*kScale24;
+    }
+}
+
+void fromFloatU8(const float * src, uint8_t * p, int i, int n)   { for (; i < n; ++i) p[i] = 128*(src[i] + 1.0f); }
+void fromFloatI8(const float * src, int8_t * p, int i, int n)    { for (; i < n; ++i) p[i] = 128*src[i]; }
+void fromFloatU16(const float * src, uint16_t * p, int i, int n) { for (; i < n; ++i) p[i] = 32768*(src[i] + 1.0f); }
+void fromFloatI16(const float * src, int16_t * p, int i, int n)  { for (; i < n; ++i) p[i] = 32768*src[i]; }
+void fromFloatI32(const float * src, int32_t * p, int i, int n)  { for (; i < n; ++i) p[i] = 2147483648.0f*src[i]; }
+void fromFloatF64(const float * src, double * p, int i, int n)   { for (; i < n; ++i) p[i] = src[i]; }
+
+void fromFloatI24(const float * src, uint8_t * p, int i, int n) {
+    for (; i < n; ++i) {
+        const int32_t v = 8388608.0f*src[i];
+        p[3*i + 0] = v;
+        p[3*i + 1] = v >> 8;
+        p[3*i + 2] = v >> 16;
+    }
+}
+
+void toFloatF32(const void * src, float * dst, int n) { std::memcpy(dst, src, n*sizeof(float)); }
+void fromFloatF32(const float * src, void * dst, int n) { std::memcpy(dst, src, n*sizeof(float)); }
+
+const Kernels kKernelsScalar = {
+    "scalar",
+    {
+        nullptr,
+        [](const void * src, float * dst, int n) { toFloatU8 ((const uint8_t  *) src, dst, 0, n); },
+        [](const void * src, float * dst, int n) { toFloatI8 ((const int8_t   *) src, dst, 0, n); },
+        [](const void * src, float * dst, int n) { toFloatU16((const uint16_t *) src, dst, 0, n); },
+        [](const void * src, float * dst, int n) { toFloatI16((const int16_t  *) src, dst, 0, n); },
+        toFloatF32,
+        [](const void * src, float * dst, int n) { toFloatI24((const uint8_t  *) src, dst, 0, n); },
+        [](const void * src, float * dst, int n) { toFloatI32((const int32_t  *) src, dst, 0, n); },
+        [](const void * src, float * dst, int n) { toFloatF64((const double   *) src, dst, 0, n); },
+    },
+    {
+        nullptr,
+        [](const float * src, void * dst, int n) { fromFloatU8 (src, (uint8_t  *) dst, 0, n); },
+        [](const float * src, void * dst, int n) { fromFloatI8 (src, (int8_t   *) dst, 0, n); },
+        [](const float * src, void * dst, int n) { fromFloatU16(src, (uint16_t *) dst, 0, n); },
+        [](const float * src, void * dst, int n) { fromFloatI16(src, (int16_t  *) dst, 0, n); },
+        fromFloatF32,
+        [](const float * src, void * dst, int n) { fromFloatI24(src, (uint8_t  *) dst, 0, n); },
+        [](const float * src, void * dst, int n) { fromFloatI32(src, (int32_t  *) dst, 0, n); },
+        [](const float * src, void * dst, int n) { fromFloatF64(src, (double   *) dst, 0, n); },
+    },
+};
+
+#ifdef GGMORSE_CONVERT_SSE2
+
+//
+// SSE2
+//
+
+void toFloatU8_sse2(const void * src, float * dst, int n) {
+    auto p = (const uint8_t *) src;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi32(128);
+    const __m128 scale = _mm_set1_ps(kScale8);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (p + i));
+        const __m128i lo = _mm_unpacklo_epi8(x, zero);
+        const __m128i hi = _mm_unpackhi_epi8(x, zero);
+        _mm_storeu_ps(dst + i +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpacklo_epi16(lo, zero), offset)), scale));
+        _mm_storeu_ps(dst + i +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpackhi_epi16(lo, zero), offset)), scale));
+        _mm_storeu_ps(dst + i +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpacklo_epi16(hi, zero), offset)), scale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpackhi_epi16(hi, zero), offset)), scale));
+    }
+    toFloatU8(p, dst, i, n);
+}
+
+void toFloatI8_sse2(const void * src, float * dst, int n) {
+    auto p = (const int8_t *) src;
+    const __m128 scale = _mm_set1_ps(kScale8);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // replicate each byte in all 4 bytes of a 32-bit lane and shift it down with sign extension
+        const __m128i x = _mm_loadu_si128((const __m128i *) (p + i));
+        const __m128i lo = _mm_unpacklo_epi8(x, x);
+        const __m128i hi = _mm_unpackhi_epi8(x, x);
+        _mm_storeu_ps(dst + i +  0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 24)), scale));
+        _mm_storeu_ps(dst + i +  4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 24)), scale));
+        _mm_storeu_ps(dst + i +  8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 24)), scale));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 24)), scale));
+    }
+    toFloatI8(p, dst, i, n);
+}
+
+void toFloatU16_sse2(const void * src, float * dst, int n) {
+    auto p = (const uint16_t *) src;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi32(32768);
+    const __m128 scale = _mm_set1_ps(kScale16);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (p + i));
+        _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpacklo_epi16(x, zero), offset)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_unpackhi_epi16(x, zero), offset)), scale));
+    }
+    toFloatU16(p, dst, i, n);
+}
+
+void toFloatI16_sse2(const void * src, float * dst, int n) {
+    auto p = (const int16_t *) src;
+    const __m128 scale = _mm_set1_ps(kScale16);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (p + i));
+        _mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+    }
+    toFloatI16(p, dst, i, n);
+}
+
+void toFloatI32_sse2(const void * src, float * dst, int n) {
+    auto p = (const int32_t *) src;
+    const __m128 scale = _mm_set1_ps(kScale32);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) (p + i));
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+    }
+    toFloatI32(p, dst, i, n);
+}
+
+void toFloatF64_sse2(const void * src, float * dst, int n) {
+    auto p = (const double *) src;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(p + i + 0));
+        const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(p + i + 2));
+        _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+    }
+    toFloatF64(p, dst, i, n);
+}
+
+void fromFloatU8_sse2(const float * src, void * dst, int n) {
+    auto p = (uint8_t *) dst;
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(128.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i +  0), one), scale));
+        const __m128i x1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i +  4), one), scale));
+        const __m128i x2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i +  8), one), scale));
+        const __m128i x3 = _mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i + 12), one), scale));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packus_epi16(_mm_packs_epi32(x0, x1), _mm_packs_epi32(x2, x3)));
+    }
+    fromFloatU8(src, p, i, n);
+}
+
+void fromFloatI8_sse2(const float * src, void * dst, int n) {
+    auto p = (int8_t *) dst;
+    const __m128 scale = _mm_set1_ps(128.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i x0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i +  0), scale));
+        const __m128i x1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i +  4), scale));
+        const __m128i x2 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i +  8), scale));
+        const __m128i x3 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 12), scale));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packs_epi16(_mm_packs_epi32(x0, x1), _mm_packs_epi32(x2, x3)));
+    }
+    fromFloatI8(src, p, i, n);
+}
+
+void fromFloatU16_sse2(const float * src, void * dst, int n) {
+    auto p = (uint16_t *) dst;
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128i offset = _mm_set1_epi32(32768);
+    const __m128i sign = _mm_set1_epi16(-32768);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // there is no unsigned saturating pack in SSE2 - pack as signed and flip the sign bit
+        const __m128i x0 = _mm_sub_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i + 0), one), scale)), offset);
+        const __m128i x1 = _mm_sub_epi32(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(_mm_loadu_ps(src + i + 4), one), scale)), offset);
+        _mm_storeu_si128((__m128i *) (p + i), _mm_xor_si128(_mm_packs_epi32(x0, x1), sign));
+    }
+    fromFloatU16(src, p, i, n);
+}
+
+void fromFloatI16_sse2(const float * src, void * dst, int n) {
+    auto p = (int16_t *) dst;
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i x0 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 0), scale));
+        const __m128i x1 = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packs_epi32(x0, x1));
+    }
+    fromFloatI16(src, p, i, n);
+}
+
+void fromFloatI32_sse2(const float * src, void * dst, int n) {
+    auto p = (int32_t *) dst;
+    const __m128 scale = _mm_set1_ps(2147483648.0f);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_si128((__m128i *) (p + i), _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), scale)));
+    }
+    fromFloatI32(src, p, i, n);
+}
+
+void fromFloatF64_sse2(const float * src, void * dst, int n) {
+    auto p = (double *) dst;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 x = _mm_loadu_ps(src + i);
+        _mm_storeu_pd(p + i + 0, _mm_cvtps_pd(x));
+        _mm_storeu_pd(p + i + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    fromFloatF64(src, p, i, n);
+}
+
+const Kernels kKernelsSSE2 = {
+    "sse2",
+    {
+        nullptr,
+        toFloatU8_sse2,
+        toFloatI8_sse2,
+        toFloatU16_sse2,
+        toFloatI16_sse2,
+        toFloatF32,
+        kKernelsScalar.toFloat[GGMORSE_SAMPLE_FORMAT_I24],
+        toFloatI32_sse2,
+        toFloatF64_sse2,
+    },
+    {
+        nullptr,
+        fromFloatU8_sse2,
+        fromFloatI8_sse2,
+        fromFloatU16_sse2,
+        fromFloatI16_sse2,
+        fromFloatF32,
+        kKernelsScalar.fromFloat[GGMORSE_SAMPLE_FORMAT_I24],
+        fromFloatI32_sse2,
+        fromFloatF64_sse2,
+    },
+};
+
+#endif
+
+#ifdef GGMORSE_CONVERT_AVX2
+
+//
+// AVX2
+//
+
+#define GGMORSE_TARGET_AVX2 __attribute__((target("avx2")))
+
+GGMORSE_TARGET_AVX2 void toFloatU8_avx2(const void * src, float * dst, int n) {
+    auto p = (const uint8_t *) src;
+    const __m256i offset = _mm256_set1_epi32(128);
+    const __m256 scale = _mm256_set1_ps(kScale8);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (p + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(x, offset)), scale));
+    }
+    toFloatU8(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void toFloatI8_avx2(const void * src, float * dst, int n) {
+    auto p = (const int8_t *) src;
+    const __m256 scale = _mm256_set1_ps(kScale8);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *) (p + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    toFloatI8(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void toFloatU16_avx2(const void * src, float * dst, int n) {
+    auto p = (const uint16_t *) src;
+    const __m256i offset = _mm256_set1_epi32(32768);
+    const __m256 scale = _mm256_set1_ps(kScale16);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *) (p + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(x, offset)), scale));
+    }
+    toFloatU16(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void toFloatI16_avx2(const void * src, float * dst, int n) {
+    auto p = (const int16_t *) src;
+    const __m256 scale = _mm256_set1_ps(kScale16);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *) (p + i)));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    toFloatI16(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void toFloatI24_avx2(const void * src, float * dst, int n) {
+    auto p = (const uint8_t *) src;
+    // move the 3 bytes of each sample to the top of a 32-bit lane and shift down with sign extension
+    const __m128i shuffle = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    const __m128 scale = _mm_set1_ps(kScale24);
+    int i = 0;
+    // each load reads 16 bytes, of which 12 are used - stay clear of the end of the buffer
+    for (; i + 6 <= n; i += 4) {
+        const __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (p + 3*i)), shuffle);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(x, 8)), scale));
+    }
+    toFloatI24(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void toFloatI32_avx2(const void * src, float * dst, int n) {
+    auto p = (const int32_t *) src;
+    const __m256 scale = _mm256_set1_ps(kScale32);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *) (p + i));
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    toFloatI32(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void toFloatF64_avx2(const void * src, float * dst, int n) {
+    auto p = (const double *) src;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(p + i)));
+    }
+    toFloatF64(p, dst, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatU8_avx2(const float * src, void * dst, int n) {
+    auto p = (uint8_t *) dst;
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(128.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i x0 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(src + i + 0), one), scale));
+        const __m256i x1 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(src + i + 8), one), scale));
+        const __m128i y0 = _mm_packs_epi32(_mm256_castsi256_si128(x0), _mm256_extracti128_si256(x0, 1));
+        const __m128i y1 = _mm_packs_epi32(_mm256_castsi256_si128(x1), _mm256_extracti128_si256(x1, 1));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packus_epi16(y0, y1));
+    }
+    fromFloatU8(src, p, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatI8_avx2(const float * src, void * dst, int n) {
+    auto p = (int8_t *) dst;
+    const __m256 scale = _mm256_set1_ps(128.0f);
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i x0 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 0), scale));
+        const __m256i x1 = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i + 8), scale));
+        const __m128i y0 = _mm_packs_epi32(_mm256_castsi256_si128(x0), _mm256_extracti128_si256(x0, 1));
+        const __m128i y1 = _mm_packs_epi32(_mm256_castsi256_si128(x1), _mm256_extracti128_si256(x1, 1));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packs_epi16(y0, y1));
+    }
+    fromFloatI8(src, p, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatU16_avx2(const float * src, void * dst, int n) {
+    auto p = (uint16_t *) dst;
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(src + i), one), scale));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packus_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+    }
+    fromFloatU16(src, p, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatI16_avx2(const float * src, void * dst, int n) {
+    auto p = (int16_t *) dst;
+    const __m256 scale = _mm256_set1_ps(32768.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i x = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale));
+        _mm_storeu_si128((__m128i *) (p + i), _mm_packs_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+    }
+    fromFloatI16(src, p, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatI24_avx2(const float * src, void * dst, int n) {
+    auto p = (uint8_t *) dst;
+    // keep the 3 low bytes of each 32-bit lane
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    const __m128 scale = _mm_set1_ps(8388608.0f);
+    int i = 0;
+    // each store writes 16 bytes, of which 12 are used - stay clear of the end of the buffer
+    for (; i + 6 <= n; i += 4) {
+        const __m128i x = _mm_cvttps_epi32(_mm_mul_ps(_mm_loadu_ps(src + i), scale));
+        _mm_storeu_si128((__m128i *) (p + 3*i), _mm_shuffle_epi8(x, shuffle));
+    }
+    fromFloatI24(src, p, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatI32_avx2(const float * src, void * dst, int n) {
+    auto p = (int32_t *) dst;
+    const __m256 scale = _mm256_set1_ps(2147483648.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_si256((__m256i *) (p + i), _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src + i), scale)));
+    }
+    fromFloatI32(src, p, i, n);
+}
+
+GGMORSE_TARGET_AVX2 void fromFloatF64_avx2(const float * src, void * dst, int n) {
+    auto p = (double *) dst;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(p + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+    }
+    fromFloatF64(src, p, i, n);
+}
+
+const Kernels kKernelsAVX2 = {
+    "avx2",
+    {
+        nullptr,
+        toFloatU8_avx2,
+        toFloatI8_avx2,
+        toFloatU16_avx2,
+        toFloatI16_avx2,
+        toFloatF32,
+        toFloatI24_avx2,
+        toFloatI32_avx2,
+        toFloatF64_avx2,
+    },
+    {
+        nullptr,
+        fromFloatU8_avx2,
+        fromFloatI8_avx2,
+        fromFloatU16_avx2,
+        fromFloatI16_avx2,
+        fromFloatF32,
+        fromFloatI24_avx2,
+        fromFloatI32_avx2,
+        fromFloatF64_avx2,
+    },
+};
+
+#endif
+
+const Kernels & selectKernels() {
+#ifdef GGMORSE_CONVERT_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return kKernelsAVX2;
+    }
+#endif
+
+#ifdef GGMORSE_CONVERT_SSE2
+    return kKernelsSSE2;
+#else
+    return kKernelsScalar;
+#endif
+}
+
+const Kernels & kernels() {
+    static const Kernels & result = selectKernels();
+    return result;
+}
+
+bool isValid(ggmorse_SampleFormat sampleFormat) {
+    return sampleFormat > GGMORSE_SAMPLE_FORMAT_UNDEFINED && sampleFormat < kNumFormats;
+}
+
+}
+
+ConvertToFloat convertToFloat(ggmorse_SampleFormat sampleFormat) {
+    return isValid(sampleFormat) ? kernels().toFloat[sampleFormat] : nullptr;
+}
+
+ConvertFromFloat convertFromFloat(ggmorse_SampleFormat sampleFormat) {
+    return isValid(sampleFormat) ? kernels().fromFloat[sampleFormat] : nullptr;
+}
+
+const char * convertKernelsName() {
+    return kernels().name;
+}
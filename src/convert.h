@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ggmorse/ggmorse.h"
+
+// Sample format conversion kernels
+//
+// The kernels are selected at runtime, based on the instruction sets supported by the CPU. The integer
+// formats are scaled to [-1, 1) and the unsigned formats are offset by half of their range.
+//
+// All formats are little-endian. GGMORSE_SAMPLE_FORMAT_I24 is packed - 3 bytes per sample.
+//
+
+// convert n samples from the given format to float
+using ConvertToFloat = void (*)(const void * src, float * dst, int n);
+
+// convert n float samples to the given format
+using ConvertFromFloat = void (*)(const float * src, void * dst, int n);
+
+// returns nullptr for GGMORSE_SAMPLE_FORMAT_UNDEFINED
+ConvertToFloat convertToFloat(ggmorse_SampleFormat sampleFormat);
+ConvertFromFloat convertFromFloat(ggmorse_SampleFormat sampleFormat);
+
+// name of the instruction set used by the kernels
+const char * convertKernelsName();
@@ -1,11 +1,13 @@
 #pragma once
 
+#include "tables.h"
+
 #include <cmath>
+#include <utility>
+#include <vector>
 
 // FFT routines taken from https://stackoverflow.com/a/37729648/4039976
 
-constexpr auto kMaxSamplesPerFrame = 1024;
-
 int log2(int N) {
     int k = N, i = 0;
     while(k) {
@@ -24,31 +26,41 @@ int reverse(int N, int n) {
     return p;
 }
 
-void ordina(float * f1, int N) {
-    float f2[2*kMaxSamplesPerFrame];
-    for (int i = 0; i < N; i++) {
-        int ir = reverse(N, i);
-        f2[2*i + 0] = f1[2*ir + 0];
-        f2[2*i + 1] = f1[2*ir + 1];
+// twiddle factors and bit-reversed order for an N-point transform, shared through sharedTable<FFTTables>(N)
+struct FFTTables {
+    explicit FFTTables(int N) : W(N), reversed(N) {
+        W[2*1 + 0] = cos(-2.*M_PI/N);
+        W[2*1 + 1] = sin(-2.*M_PI/N);
+        W[2*0 + 0] = 1;
+        W[2*0 + 1] = 0;
+        for (int i = 2; i < N / 2; i++) {
+            W[2*i + 0] = cos(-2.*i*M_PI/N);
+            W[2*i + 1] = sin(-2.*i*M_PI/N);
+        }
+        for (int i = 0; i < N; i++) {
+            reversed[i] = reverse(N, i);
+        }
     }
-    for (int j = 0; j < N; j++) {
-        f1[2*j + 0] = f2[2*j + 0];
-        f1[2*j + 1] = f2[2*j + 1];
+
+    std::vector<float> W;
+    std::vector<int> reversed;
+};
+
+void ordina(float * f1, const FFTTables & tables) {
+    int N = (int) tables.reversed.size();
+    for (int i = 0; i < N; i++) {
+        int ir = tables.reversed[i];
+        if (i < ir) {
+            std::swap(f1[2*i + 0], f1[2*ir + 0]);
+            std::swap(f1[2*i + 1], f1[2*ir + 1]);
+        }
     }
 }
 
-void transform(float * f, int N) {
-    ordina(f, N);    //first: reverse order
-    float * W;
-    W = (float *)malloc(N*sizeof(float));
-    W[2*1 + 0] = cos(-2.*M_PI/N);
-    W[2*1 + 1] = sin(-2.*M_PI/N);
-    W[2*0 + 0] = 1;
-    W[2*0 + 1] = 0;
-    for (int i = 2; i < N / 2; i++) {
-        W[2*i + 0] = cos(-2.*i*M_PI/N);
-        W[2*i + 1] = sin(-2.*i*M_PI/N);
-    }
+void transform(float * f, const FFTTables & tables) {
+    ordina(f, tables);    //first: reverse order
+    int N = (int) tables.reversed.size();
+    const float * W = tables.W.data();
     int n = 1;
     int a = N / 2;
     for(int j = 0; j < log2(N); j++) {
@@ -71,17 +83,20 @@ void transform(float * f, int N) {
         n *= 2;
         a = a / 2;
     }
-    free(W);
 }
 
-void FFT(float * f, int N, float d) {
-    transform(f, N);
-    for (int i = 0; i < N; i++) {
+void FFT(float * f, const FFTTables & tables, float d) {
+    transform(f, tables);
+    for (int i = 0; i < (int) tables.reversed.size(); i++) {
         f[2*i + 0] *= d;
         f[2*i + 1] *= d;
     }
 }
 
+void FFT(float * f, int N, float d) {
+    FFT(f, sharedTable<FFTTables>(N), d);
+}
+
 void FFT(float * src, float * dst, int N, float d) {
     for (int i = 0; i < N; ++i) {
         dst[2*i + 0] = src[i];
@@ -6,14 +6,13 @@
 #define  pi 3.1415926535897932384626433832795
 #endif
 
-#ifndef sqrt2
-#define sqrt2 (2.0 * 0.707106781186547524401)
-#endif
-
-#ifndef sqrt2over2
-#define  sqrt2over2  0.707106781186547524401
-#endif
-
+// Cascade of biquad sections in transposed direct form II
+//
+// Butterworth filters of arbitrary order (up to kMaxOrder) are split into order/2 second-order sections,
+// plus one first-order section when the order is odd. The samples are processed in blocks - each section
+// runs over the whole block with its state kept in local variables, so the recurrence does not go through
+// memory on every sample.
+//
 struct Filter {
     enum EType {
         None = 0,
@@ -21,10 +20,31 @@ struct Filter {
         FirstOrderLowPass,
         SecondOrderButterworthHighPass,
         SecondOrderButterworthLowPass,
+        ButterworthHighPass,
+        ButterworthLowPass,
+    };
+
+    static constexpr int kMaxOrder = 8;
+    static constexpr int kMaxSections = (kMaxOrder + 1)/2;
+
+    // added to the input of each section to keep the state out of the denormal range when the input is silent
+    static constexpr float kAntiDenormal = 1e-20f;
+
+    // numerator : b0, b1, b2
+    // denominator : 1, a1, a2
+    struct Section {
+        float b0 = 1.0f;
+        float b1 = 0.0f;
+        float b2 = 0.0f;
+        float a1 = 0.0f;
+        float a2 = 0.0f;
     };
 
-    void init(EType type, float freqCutoff_Hz, float sampleRate) {
+    // the order is used only by the ButterworthHighPass and ButterworthLowPass types
+    void init(EType type, float freqCutoff_Hz, float sampleRate, int order = 2) {
         m_type = type;
+        m_nSections = 0;
+
         switch (type) {
             case EType::None:
                 {
@@ -32,108 +52,207 @@ struct Filter {
                 break;
             case EType::FirstOrderHighPass:
                 {
-                    calculateCoefficientsFirstOrderHighPass(freqCutoff_Hz, sampleRate);
+                    calculateCoefficientsButterworth(false, 1, freqCutoff_Hz, sampleRate);
                 }
                 break;
             case EType::FirstOrderLowPass:
                 {
-                    calculateCoefficientsFirstOrderLowPass(freqCutoff_Hz, sampleRate);
+                    calculateCoefficientsButterworth(true, 1, freqCutoff_Hz, sampleRate);
                 }
                 break;
             case EType::SecondOrderButterworthHighPass:
                 {
-                    calculateCoefficientsSecondOrderButterworthHighPass(freqCutoff_Hz, sampleRate);
+                    calculateCoefficientsButterworth(false, 2, freqCutoff_Hz, sampleRate);
                 }
                 break;
             case EType::SecondOrderButterworthLowPass:
                 {
-                    calculateCoefficientsSecondOrderButterworthLowPass(freqCutoff_Hz, sampleRate);
+                    calculateCoefficientsButterworth(true, 2, freqCutoff_Hz, sampleRate);
                 }
                 break;
-        };
-    }
-
-    void process(float * samples, int n) {
-        switch (m_type) {
-            case EType::None:
+            case EType::ButterworthHighPass:
                 {
+                    calculateCoefficientsButterworth(false, order, freqCutoff_Hz, sampleRate);
                 }
                 break;
-            case EType::FirstOrderHighPass:
-            case EType::FirstOrderLowPass:
-            case EType::SecondOrderButterworthHighPass:
-            case EType::SecondOrderButterworthLowPass:
+            case EType::ButterworthLowPass:
                 {
-                    for (int i = 0; i < n; ++i) {
-                        samples[i] = filterBiquad(samples[i]);
-                    }
+                    calculateCoefficientsButterworth(true, order, freqCutoff_Hz, sampleRate);
                 }
                 break;
+        };
+
+        reset();
+    }
+
+    void reset() {
+        for (int k = 0; k < kMaxSections; ++k) {
+            m_z1[k] = 0.0f;
+            m_z2[k] = 0.0f;
         }
     }
 
-private:
-    void calculateCoefficientsFirstOrderHighPass(int fc, int fs) {
-        float th = 2.0 * pi * fc / fs;
-        float g = cos(th) / (1.0 + sin(th));
-        this->a0 = (1.0 + g) / 2.0;
-        this->a1 = -((1.0 + g) / 2.0);
-        this->a2 = 0.0;
-        this->b1 = -g;
-        this->b2 = 0.0;
+    int nSections() const { return m_nSections; }
+    const Section & section(int k) const { return m_sections[k]; }
+
+    void process(float * samples, int n) {
+        process(samples, samples, n);
     }
 
-    void calculateCoefficientsFirstOrderLowPass(int fc, int fs) {
-        float th = 2.0 * pi * fc / fs;
-        float g = cos(th) / (1.0 + sin(th));
-        this->a0 = (1.0 - g) / 2.0;
-        this->a1 = (1.0 - g) / 2.0;
-        this->a2 = 0.0;
-        this->b1 = -g;
-        this->b2 = 0.0;
+    // src and dst can be the same buffer
+    void process(const float * src, float * dst, int n) {
+        if (m_nSections == 0) {
+            if (src != dst) {
+                for (int i = 0; i < n; ++i) dst[i] = src[i];
+            }
+            return;
+        }
+
+        for (int k = 0; k < m_nSections; ++k) {
+            const float b0 = m_sections[k].b0;
+            const float b1 = m_sections[k].b1;
+            const float b2 = m_sections[k].b2;
+            const float a1 = m_sections[k].a1;
+            const float a2 = m_sections[k].a2;
+
+            float z1 = m_z1[k];
+            float z2 = m_z2[k];
+
+            const float * x = k == 0 ? src : dst;
+            for (int i = 0; i < n; ++i) {
+                const float xn = x[i] + kAntiDenormal;
+                const float yn = b0*xn + z1;
+                z1 = b1*xn - a1*yn + z2;
+                z2 = b2*xn - a2*yn;
+                dst[i] = yn;
+            }
+
+            m_z1[k] = z1;
+            m_z2[k] = z2;
+        }
     }
 
-    void calculateCoefficientsSecondOrderButterworthHighPass(int fc, int fs) {
-        float c = tan(pi*fc / fs);
-        this->a0 = 1.0 / (1.0 + sqrt2*c + pow(c, 2.0));
-        this->a1 = -2.0 * this->a0;
-        this->a2 = this->a0;
-        this->b1 = 2.0 * this->a0*(pow(c, 2.0) - 1.0);
-        this->b2 = this->a0 * (1.0 - sqrt2*c + pow(c, 2.0));
+private:
+    // bilinear transform of the analog Butterworth prototype, with the cutoff frequency pre-warped
+    void calculateCoefficientsButterworth(bool lowPass, int order, float fc, float fs) {
+        if (order < 1) order = 1;
+        if (order > kMaxOrder) order = kMaxOrder;
+
+        const double K = std::tan(pi*double(fc)/double(fs));
+        const double K2 = K*K;
+
+        m_nSections = 0;
+        for (int k = 0; k < order/2; ++k) {
+            const double q = 1.0/(2.0*std::sin((2*k + 1)*pi/(2.0*order)));
+            const double norm = 1.0/(1.0 + K/q + K2);
+
+            auto & s = m_sections[m_nSections++];
+            if (lowPass) {
+                s.b0 = K2*norm;
+                s.b1 = 2.0*s.b0;
+                s.b2 = s.b0;
+            } else {
+                s.b0 = norm;
+                s.b1 = -2.0*s.b0;
+                s.b2 = s.b0;
+            }
+            s.a1 = 2.0*(K2 - 1.0)*norm;
+            s.a2 = (1.0 - K/q + K2)*norm;
+        }
+
+        if (order % 2 == 1) {
+            const double norm = 1.0/(1.0 + K);
+
+            auto & s = m_sections[m_nSections++];
+            if (lowPass) {
+                s.b0 = K*norm;
+                s.b1 = s.b0;
+            } else {
+                s.b0 = norm;
+                s.b1 = -s.b0;
+            }
+            s.b2 = 0.0f;
+            s.a1 = (K - 1.0)*norm;
+            s.a2 = 0.0f;
+        }
     }
 
-    void calculateCoefficientsSecondOrderButterworthLowPass(int fc, int fs) {
-        float c = 1.0 / tan(pi*fc / fs);
-        this->a0 = 1.0 / (1.0 + sqrt2*c + pow(c, 2.0));
-        this->a1 = 2.0 * this->a0;
-        this->a2 = this->a0;
-        this->b1 = 2.0 * this->a0*(1.0 - pow(c, 2.0));
-        this->b2 = this->a0 * (1.0 - sqrt2*c + pow(c, 2.0));
+    EType m_type = EType::None;
+
+    int m_nSections = 0;
+    Section m_sections[kMaxSections];
+
+    float m_z1[kMaxSections] = {};
+    float m_z2[kMaxSections] = {};
+};
+
+// Same cascade applied to kLanes independent streams at once
+//
+// The samples of the streams are interleaved: samples[i*kLanes + lane]. All lanes share the coefficients and
+// each lane has its own state. The inner loop over the lanes has a fixed trip count and no dependencies
+// between iterations, so the compiler maps it to one SIMD register per state variable.
+//
+template <int kLanes>
+struct FilterLanes {
+    void init(Filter::EType type, float freqCutoff_Hz, float sampleRate, int order = 2) {
+        Filter tmp;
+        tmp.init(type, freqCutoff_Hz, sampleRate, order);
+
+        m_nSections = tmp.nSections();
+        for (int k = 0; k < m_nSections; ++k) {
+            m_sections[k] = tmp.section(k);
+        }
+
+        reset();
     }
 
-    float filterBiquad(float sample) {
-        float xn = sample;
-        float yn =
-            this->a0*xn + this->a1*this->xnz1 + this->a2*this->xnz2 -
-            this->b1*this->ynz1 - this->b2*this->xnz2;
+    void reset() {
+        for (int k = 0; k < Filter::kMaxSections; ++k) {
+            for (int l = 0; l < kLanes; ++l) {
+                m_z1[k][l] = 0.0f;
+                m_z2[k][l] = 0.0f;
+            }
+        }
+    }
 
-        this->xnz2 = this->xnz1;
-        this->xnz1 = xn;
-        this->xnz2 = this->ynz1;
-        this->ynz1 = yn;
+    // n is the number of samples per lane
+    void process(float * samples, int n) {
+        for (int k = 0; k < m_nSections; ++k) {
+            const float b0 = m_sections[k].b0;
+            const float b1 = m_sections[k].b1;
+            const float b2 = m_sections[k].b2;
+            const float a1 = m_sections[k].a1;
+            const float a2 = m_sections[k].a2;
 
-        return yn;
+            float z1[kLanes];
+            float z2[kLanes];
+            for (int l = 0; l < kLanes; ++l) {
+                z1[l] = m_z1[k][l];
+                z2[l] = m_z2[k][l];
+            }
+
+            for (int i = 0; i < n; ++i) {
+                float * x = samples + i*kLanes;
+                for (int l = 0; l < kLanes; ++l) {
+                    const float xn = x[l] + Filter::kAntiDenormal;
+                    const float yn = b0*xn + z1[l];
+                    z1[l] = b1*xn - a1*yn + z2[l];
+                    z2[l] = b2*xn - a2*yn;
+                    x[l] = yn;
+                }
+            }
+
+            for (int l = 0; l < kLanes; ++l) {
+                m_z1[k][l] = z1[l];
+                m_z2[k][l] = z2[l];
+            }
+        }
     }
 
-    EType m_type;
-
-    float a0;
-    float a1;
-    float a2;
-    float b1;
-    float b2;
-    
-    float xnz1;
-    float xnz2;
-    float ynz1;
+private:
+    int m_nSections = 0;
+    Filter::Section m_sections[Filter::kMaxSections];
+
+    float m_z1[Filter::kMaxSections][kLanes] = {};
+    float m_z2[Filter::kMaxSections][kLanes] = {};
 };
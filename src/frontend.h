@@ -0,0 +1,208 @@
+#pragma once
+
+#include "ggmorse/ggmorse.h"
+
+#include "convert.h"
+#include "filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Input front-end of the decoder
+//
+// Converts the captured samples to float, applies the anti-aliasing low-pass filter and decimates to the
+// base sample rate - all in a single pass. The input is processed in
+// chunks of kChunkSize samples that are staged in a small buffer on the stack, so the intermediate results
+// never leave the L1 cache. Only the final base-rate samples are written to memory.
+//
+// Interleaved multi-channel input is reduced to a single channel in the same pass - either by picking one of
+// the channels or by averaging all of them. A picked channel is gathered before the conversion, so only its
+// samples are converted - the per-channel decoders of GGMORSE_CHANNEL_MODE_INDEPENDENT do not convert each
+// other's channels.
+//
+// Integer rate ratios are decimated by picking every N-th sample. Other ratios are resampled with cubic
+// (Catmull-Rom) interpolation between the low-passed input samples.
+//
+struct FrontEnd {
+    static constexpr int kChunkSize = 64;
+    static constexpr int kMaxSampleSizeBytes = 8;
+
+    void init(
+            ggmorse_SampleFormat sampleFormat,
+            int sampleSizeBytes,
+            float sampleRateInp,
+            float sampleRateOut) {
+        m_sampleFormat = sampleFormat;
+        m_sampleSizeBytes = sampleSizeBytes;
+        m_convert = convertToFloat(sampleFormat);
+        m_sampleRateInp = sampleRateInp;
+
+        const double ratio = double(sampleRateInp)/sampleRateOut;
+
+        m_stepInt = std::round(ratio);
+        m_isInteger = m_stepInt >= 1 && std::fabs(ratio - m_stepInt) < 1e-6;
+        m_step = ratio;
+
+        reset();
+    }
+
+    // with downmix == false, only the given channel is used
+    void initChannels(int channels, bool downmix, int channel) {
+        m_channels = channels;
+        m_downmix = downmix;
+        m_channel = channel;
+    }
+
+    void initFilter(float freqCutoffLowPass_Hz, int orderLowPass) {
+        m_filterLowPass.init(Filter::ButterworthLowPass, freqCutoffLowPass_Hz, m_sampleRateInp, orderLowPass);
+    }
+
+    // F32 input at the output sample rate - the samples can be used as they are
+    bool isIdentity() const {
+        return m_sampleFormat == GGMORSE_SAMPLE_FORMAT_F32 && m_channels == 1 && m_isInteger && m_stepInt == 1;
+    }
+
+    void reset() {
+        m_skip = 0;
+        m_time = 0.0;
+        for (auto & h : m_hist) h = 0.0f;
+
+        m_filterLowPass.reset();
+    }
+
+    // number of input samples that have to be processed to produce exactly nOut output samples
+    int nSamplesNeeded(int nOut) const {
+        if (nOut <= 0) return 0;
+
+        if (m_isInteger) {
+            return m_skip + 1 + (nOut - 1)*m_stepInt;
+        }
+
+        return int(std::floor(m_time + (nOut - 1)*m_step)) + 3;
+    }
+
+    // process nInp input samples (with all of their channels) and write the produced output samples to dst
+    // returns the number of output samples
+    int process(const void * src, int nInp, float * dst, bool applyFilterLowPass) {
+        const bool applyLowPass = applyFilterLowPass && (m_isInteger == false || m_stepInt > 1);
+
+        float chunk[kChunkSize];
+
+        int nOut = 0;
+        for (int i0 = 0; i0 < nInp; i0 += kChunkSize) {
+            const int n = std::min(kChunkSize, nInp - i0);
+
+            convert(reinterpret_cast<const uint8_t *>(src) + i0*m_channels*m_sampleSizeBytes, n, chunk);
+
+            if (applyLowPass) {
+                m_filterLowPass.process(chunk, n);
+            }
+
+            nOut += m_isInteger ? decimate(chunk, n, dst + nOut) : interpolate(chunk, n, dst + nOut);
+        }
+
+        return nOut;
+    }
+
+private:
+    void convert(const uint8_t * src, int n, float * dst) const {
+        if (m_channels == 1) {
+            m_convert(src, dst, n);
+            return;
+        }
+
+        if (m_downmix) {
+            float interleaved[kChunkSize*GGMorse::kMaxChannels];
+            m_convert(src, interleaved, n*m_channels);
+
+            const float scale = 1.0f/m_channels;
+            for (int i = 0; i < n; ++i) {
+                float sum = 0.0f;
+                for (int c = 0; c < m_channels; ++c) {
+                    sum += interleaved[i*m_channels + c];
+                }
+                dst[i] = sum*scale;
+            }
+        } else {
+            uint8_t selected[kChunkSize*kMaxSampleSizeBytes];
+            gather(src + m_channel*m_sampleSizeBytes, n, selected);
+            m_convert(selected, dst, n);
+        }
+    }
+
+    // copy every m_channels-th sample of src to dst
+    void gather(const uint8_t * src, int n, uint8_t * dst) const {
+        const int stride = m_channels*m_sampleSizeBytes;
+        switch (m_sampleSizeBytes) {
+            case 1: for (int i = 0; i < n; ++i) dst[i] = src[i*stride]; break;
+            case 2: for (int i = 0; i < n; ++i) std::memcpy(dst + 2*i, src + i*stride, 2); break;
+            case 4: for (int i = 0; i < n; ++i) std::memcpy(dst + 4*i, src + i*stride, 4); break;
+            case 8: for (int i = 0; i < n; ++i) std::memcpy(dst + 8*i, src + i*stride, 8); break;
+            default:
+                for (int i = 0; i < n; ++i) std::memcpy(dst + i*m_sampleSizeBytes, src + i*stride, m_sampleSizeBytes);
+        }
+    }
+
+    int decimate(const float * samples, int n, float * dst) {
+        int nOut = 0;
+        for (int i = m_skip; i < n; i += m_stepInt) {
+            dst[nOut++] = samples[i];
+        }
+
+        // number of samples to skip from the next chunk
+        m_skip = (m_skip - n) % m_stepInt;
+        if (m_skip < 0) m_skip += m_stepInt;
+
+        return nOut;
+    }
+
+    // m_time is the position of the next output sample, relative to the next input sample
+    // an output sample is produced once the 2 input samples after it are available
+    int interpolate(const float * samples, int n, float * dst) {
+        int nOut = 0;
+        for (int i = 0; i < n; ++i) {
+            m_hist[0] = m_hist[1];
+            m_hist[1] = m_hist[2];
+            m_hist[2] = m_hist[3];
+            m_hist[3] = samples[i];
+
+            while (m_time < -1.0) {
+                const float t = m_time + 2.0;
+
+                const float p0 = m_hist[0];
+                const float p1 = m_hist[1];
+                const float p2 = m_hist[2];
+                const float p3 = m_hist[3];
+
+                dst[nOut++] = p1 + 0.5f*t*((p2 - p0) + t*((2.0f*p0 - 5.0f*p1 + 4.0f*p2 - p3) + t*(3.0f*(p1 - p2) + p3 - p0)));
+
+                m_time += m_step;
+            }
+
+            m_time -= 1.0;
+        }
+
+        return nOut;
+    }
+
+    ggmorse_SampleFormat m_sampleFormat = GGMORSE_SAMPLE_FORMAT_UNDEFINED;
+    int m_sampleSizeBytes = 0;
+    ConvertToFloat m_convert = nullptr;
+
+    int m_channels = 1;
+    bool m_downmix = false;
+    int m_channel = 0;
+    float m_sampleRateInp = 0.0f;
+
+    bool m_isInteger = true;
+    int m_stepInt = 1;
+    double m_step = 1.0;
+
+    int m_skip = 0;
+    double m_time = 0.0;
+    float m_hist[4] = {};
+
+    Filter m_filterLowPass;
+};
@@ -1,13 +1,23 @@
 #include "ggmorse/ggmorse.h"
 
+#include "baseband.h"
+#include "codebook.h"
+#include "convert.h"
 #include "stfft.h"
-#include "filter.h"
+#include "frontend.h"
 #include "goertzel.h"
-#include "resampler.h"
+#include "history.h"
+#include "oscillator.h"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <string>
-#include <unordered_map>
+#include <thread>
 
 //
 // C++ implementation
@@ -15,75 +25,110 @@
 
 namespace {
 
+// band-limiting of the input signal
+// the low-pass filter is applied at the capture sample rate before decimation to kBaseSampleRate
+constexpr int kFilterOrderHighPass = 2;
+constexpr int kFilterOrderLowPass = 4;
+
+// detection bandwidth for I/Q input - about the bandwidth of the Goertzel filter used for audio input
+constexpr float kBandwidthIQ_hz = 50.0f;
+constexpr int kFilterOrderIQ = 4;
+
+// the frequency tracker is reset to the pitch estimate after it has disagreed with it for this many frames
+constexpr int kFramesToReacquire = 8;
+
+// skimmer mode - minimum spacing of the decoded signals and their minimum power above the noise floor
+// a signal is retuned when its spectral peak moves by more than the tolerance
+constexpr float kSkimmerSpacing_hz = 50.0f;
+constexpr float kSkimmerTolerance_hz = 15.0f;
+constexpr float kSkimmerThreshold = 10.0f;
+
+// the encoder synthesizes the transmission in chunks of this many samples
+constexpr int kEncodeChunkSamples = 1024;
+
+// number of encode parameter sets for which the encoder keeps the element waveforms
+constexpr int kMaxElementTemplates = 8;
+
 float lendot_ms(float speed_wpm) {
     return 60000.0f/(50.0f*speed_wpm);
 }
 
-char toUpper(char c) {
-    if (c >= 'a' && c <= 'z') return c -= 'a' - 'A';
-    return c;
-}
-
 // 0 - dot
 // 1 - dash
-using TAlphabet = std::unordered_map<std::string, char>;
-const TAlphabet kMorseCode = {
-    { "01",      'A',  },
-    { "1000",    'B',  },
-    { "1010",    'C',  },
-    { "100",     'D',  },
-    { "0",       'E',  },
-    { "0010",    'F',  },
-    { "110",     'G',  },
-    { "0000",    'H',  },
-    { "00",      'I',  },
-    { "0111",    'J',  },
-    { "101",     'K',  },
-    { "0100",    'L',  },
-    { "11",      'M',  },
-    { "10",      'N',  },
-    { "111",     'O',  },
-    { "0110",    'P',  },
-    { "1101",    'Q',  },
-    { "010",     'R',  },
-    { "000",     'S',  },
-    { "1",       'T',  },
-    { "001",     'U',  },
-    { "0001",    'V',  },
-    { "011",     'W',  },
-    { "1001",    'X',  },
-    { "1011",    'Y',  },
-    { "1100",    'Z',  },
-    { "01111",   '1',  },
-    { "00111",   '2',  },
-    { "00011",   '3',  },
-    { "00001",   '4',  },
-    { "00000",   '5',  },
-    { "10000",   '6',  },
-    { "11000",   '7',  },
-    { "11100",   '8',  },
-    { "11110",   '9',  },
-    { "11111",   '0',  },
-    { "010101",  '.',  },
-    { "110011",  ',',  },
-    { "001100",  '?',  },
-    { "011110",  '\'', },
-    { "101011",  '!',  },
-    { "10010",   '/',  },
-    { "10110",   '(',  },
-    { "101101",  ')',  },
-    { "01000",   '&',  },
-    { "111000",  ':',  },
-    { "101010",  ';',  },
-    { "10001",   '=',  },
-    { "01010",   '+',  },
-    { "100001",  '-',  },
-    { "001101",  '_',  },
-    { "010010",  '"',  },
-    { "0001001", '$',  },
-    { "011010",  '@',  },
+struct MorseCodeEntry {
+    const char * s01;
+    const char * text;
 };
 
+constexpr MorseCodeEntry kMorseCodeTable[] = {
+    { "01",      "A", },
+    { "1000",    "B", },
+    { "1010",    "C", },
+    { "100",     "D", },
+    { "0",       "E", },
+    { "0010",    "F", },
+    { "110",     "G", },
+    { "0000",    "H", },
+    { "00",      "I", },
+    { "0111",    "J", },
+    { "101",     "K", },
+    { "0100",    "L", },
+    { "11",      "M", },
+    { "10",      "N", },
+    { "111",     "O", },
+    { "0110",    "P", },
+    { "1101",    "Q", },
+    { "010",     "R", },
+    { "000",     "S", },
+    { "1",       "T", },
+    { "001",     "U", },
+    { "0001",    "V", },
+    { "011",     "W", },
+    { "1001",    "X", },
+    { "1011",    "Y", },
+    { "1100",    "Z", },
+    { "01111",   "1", },
+    { "00111",   "2", },
+    { "00011",   "3", },
+    { "00001",   "4", },
+    { "00000",   "5", },
+    { "10000",   "6", },
+    { "11000",   "7", },
+    { "11100",   "8", },
+    { "11110",   "9", },
+    { "11111",   "0", },
+    { "010101",  ".", },
+    { "110011",  ",", },
+    { "001100",  "?", },
+    { "011110",  "'", },
+    { "101011",  "!", },
+    { "10010",   "/", },
+    { "10110",   "(", },
+    { "101101",  ")", },
+    { "01000",   "&", },
+    { "111000",  ":", },
+    { "101010",  ";", },
+    { "10001",   "=", },
+    { "01010",   "+", },
+    { "100001",  "-", },
+    { "001101",  "_", },
+    { "010010",  "\"", },
+    { "0001001", "$", },
+    { "011010",  "@", },
+};
+
+constexpr Codebook makeMorseCode() {
+    Codebook result;
+    for (const auto & entry : kMorseCodeTable) {
+        result.set(entry.s01, entry.text);
+    }
+
+    return result;
+}
+
+// shared by all instances - an instance makes its own copy when a character is modified
+constexpr Codebook kMorseCode = makeMorseCode();
+
 uint64_t t_us() {
     return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count(); // duh ..
 }
@@ -100,6 +145,9 @@ int bytesForSampleFormat(GGMorse::SampleFormat sampleFormat) {
         case GGMORSE_SAMPLE_FORMAT_U16:          return sizeof(uint16_t);    break;
         case GGMORSE_SAMPLE_FORMAT_I16:          return sizeof(int16_t);     break;
         case GGMORSE_SAMPLE_FORMAT_F32:          return sizeof(float);       break;
+        case GGMORSE_SAMPLE_FORMAT_I24:          return 3;                   break;
+        case GGMORSE_SAMPLE_FORMAT_I32:          return sizeof(int32_t);     break;
+        case GGMORSE_SAMPLE_FORMAT_F64:          return sizeof(double);      break;
     };
 
     fprintf(stderr, "Invalid sample format: %d\n", (int) sampleFormat);
@@ -107,6 +155,112 @@ int bytesForSampleFormat(GGMorse::SampleFormat sampleFormat) {
     return 0;
 }
 
+// modify a character of the alphabet of an instance
+bool setCodebookCharacter(const Codebook * & codebook, std::unique_ptr<Codebook> & codebookModified, const std::string & s01, const std::string & text) {
+    if (codebookModified == nullptr) {
+        codebookModified = std::make_unique<Codebook>(*codebook);
+        codebook = codebookModified.get();
+    }
+
+    if (codebookModified->set(s01.c_str(), text.c_str()) == false) {
+        fprintf(stderr, "Invalid character: '%s' - '%s'\n", s01.c_str(), text.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// 0 - dot
+// 1 - dash
+// 2 - pause between symbols
+// 3 - pause between letters
+// 4 - pause between words
+//
+// durations of the symbols in samples, fixed for the whole transmission
+struct SymbolTiming {
+    int lendot0_samples = 0;            // dots and dashes, at the character speed
+    int lendot1_samples = 0;            // pauses, at the Farnsworth speed
+    int lenLetterSpace_samples = 0;
+    int lenWordSpace_samples = 0;
+
+    // rate of the ramp-up and ramp-down of the tone per sample
+    float dampFactor = 0.0f;
+
+    void init(const GGMorse::ParametersEncode & parameters, float sampleRate) {
+        lendot0_samples = sampleRate*(1e-3*lendot_ms(parameters.speedCharacters_wpm));
+        lendot1_samples = sampleRate*(1e-3*lendot_ms(parameters.speedFarnsworth_wpm));
+
+        lenLetterSpace_samples = 3.0f*lendot1_samples;
+        lenWordSpace_samples = 7.0f*lendot1_samples;
+
+        dampFactor = 1.0f/std::max(1.0f, 0.1f*lendot0_samples);
+    }
+
+    int length(char symbol) const {
+        switch (symbol) {
+            case '0': return 1*lendot0_samples;
+            case '1': return 3*lendot0_samples;
+            case '2': return lendot1_samples;
+            case '3': return lenLetterSpace_samples;
+            case '4': return lenWordSpace_samples;
+        }
+
+        return 0;
+    }
+};
+
+// append the symbols of the character at byte i of the message and of the pause that follows it
+// returns the number of bytes of the character
+int appendSymbols(const Codebook & codebook, const GGMorse::TxRx & txData, int i, std::string & dst) {
+    const int n = (int) txData.size();
+
+    Codebook::Code code;
+    const int nBytes = codebook.encode(txData.data() + i, n - i, code);
+
+    for (int k = 0; k < code.length; ++k) {
+        dst += (code.bits >> k) & 1 ? '1' : '0';
+        if (k < code.length - 1) {
+            dst += '2';
+        }
+    }
+
+    if (i + nBytes < n) {
+        if (txData[i] != ' ') {
+            dst += txData[i + nBytes] != ' ' ? '3' : '4';
+        }
+    }
+
+    return nBytes;
+}
+
+// number of samples of the whole transmission of the message, with the leading and the trailing pause
+uint64_t transmissionSize_samples(const Codebook & codebook, const GGMorse::ParametersEncode & parameters, float sampleRate, const GGMorse::TxRx & txData) {
+    SymbolTiming timing;
+    timing.init(parameters, sampleRate);
+
+    uint64_t result = 2*timing.length('2');
+
+    std::string symbols;
+    for (int i = 0; i < (int) txData.size(); ) {
+        symbols.clear();
+        i += appendSymbols(codebook, txData, i, symbols);
+
+        for (const char s : symbols) {
+            result += timing.length(s);
+        }
+    }
+
+    return result;
+}
+
+bool isSameEncode(const GGMorse::ParametersEncode & a, const GGMorse::ParametersEncode & b) {
+    return
+        a.volume == b.volume &&
+        a.frequency_hz == b.frequency_hz &&
+        a.speedCharacters_wpm == b.speedCharacters_wpm &&
+        a.speedFarnsworth_wpm == b.speedFarnsworth_wpm;
+}
+
 struct Interval {
     int signal = 0;
     int start = 0;
@@ -119,73 +273,168 @@ struct Interval {
 
 }
 
-struct GGMorse::Impl {
-    const float sampleRateInp;
+struct GGMorseDecoder::Receiver {
+    Statistics statistics = {};
+    TxRx rxData = {};
+
+    int nFramesWithCurSpeed = 0;
+
+    Interval lastInterval = {};
+    Codebook::Code curLetter = {};
+
+    // intervals of the candidate being analyzed and of the best candidate so far
+    std::vector<Interval> intervals = {};
+    std::vector<Interval> intervalsBest = {};
+};
+
+struct GGMorseEncoder::Impl {
     const float sampleRateOut;
-    const int samplesPerFrame;
-    const int sampleSizeBytesInp;
     const int sampleSizeBytesOut;
-    const SampleFormat sampleFormatInp;
     const SampleFormat sampleFormatOut;
 
-    int samplesNeeded;
-    int framesProcessed = 0;
     int txDataLength = 0;
-    int nFramesWithCurSpeed = 0;
 
     bool hasNewTxData = false;
-    bool hasNewWaveform = false;
-    bool hasNewSpectrogram = false;
-    bool receivingData = false;
-    bool lastDecodeResult = false;
 
-    ParametersDecode parametersDecode = getDefaultParametersDecode();
     ParametersEncode parametersEncode = getDefaultParametersEncode();
 
-    Statistics statistics = {};
-
-    Interval lastInterval = {};
-    std::string curLetter = "";
-
-    WaveformF waveform = WaveformF(2*kMaxSamplesPerFrame + 128);
-    WaveformF waveformResampled = WaveformF(2*kMaxSamplesPerFrame + 128);
-    TxRx waveformTmp = TxRx((2*kMaxSamplesPerFrame + 128)*sampleSizeBytesInp);
-    Spectrogram spectrogram = Spectrogram(0);
-
-    TxRx rxData = {};
     TxRx txData = {};
-    SignalF signalF = {};
     WaveformI16 txWaveformI16 = {};
 
+    // transmission cursor - character txPos - 1 is the next one to expand into symbols, so the symbols being sent
+    // belong to the characters before it
+    // txPos is 1 during the leading pause, txDataLength + 1 once the last character has been expanded and
+    // txDataLength + 2 during the trailing pause
+    int txPos = 0;
+    int iSymbol = 0;
+    int nSymbolSamples = 0;
+    int nSymbolSamplesLeft = 0;
+    int64_t txSample = 0;
+    float factorCur = 0.0f;
+    float factorSymbolStart = 0.0f;
+    std::string symbols = {};
+
+    // keyer mode - the transmission goes on with silence while there is no text to send
+    // the pause after the last character depends on the next one, so it is sent when the next one is appended,
+    // shortened by the silence sent in the meantime
+    bool isKeyer = false;
+    bool isGapPending = false;
+    int nIdleSamples = 0;
+    int nGapSamples = 0;
+
+    // timing of the current transmission
+    SymbolTiming timing = {};
+
+    Oscillator oscillator = {};
+
+    // waveforms of the keyed elements for one set of encode parameters
+    // the envelope of every dot and dash is the same, and so is the one at the start of every pause, so the
+    // elements are rendered from these, at the phase of the oscillator
+    struct ElementTemplates {
+        ParametersEncode parameters = {};
+
+        ToneTemplate tone = {};     // ramp up and steady tone, as long as a dash - a dot is its first third
+        ToneTemplate decay = {};    // ramp down at the start of a pause
+    };
+
+    // kept across messages, the most recently created last
+    std::vector<std::unique_ptr<ElementTemplates>> elementTemplates = {};
+    const ElementTemplates * elementTemplatesCur = nullptr;
+
+    // one chunk of the output - in the output sample format and as 32-bit float
     TxRx outputBlockTmp = {};
     WaveformF outputBlockF = {};
-    WaveformI16 outputBlockI16 = {};
 
-    // todo : refactor
-    std::vector<std::vector<std::vector<Interval>>> intervalsAll = {};
+    const Codebook * codebook = &kMorseCode;
+    std::unique_ptr<Codebook> codebookModified = {};
+};
+
+struct GGMorseDecoder::Impl {
+    const float sampleRateInp;
+    const int samplesPerFrame;
+    const int sampleSizeBytesInp;
+    const SampleFormat sampleFormatInp;
+
+    int channelsInp = 1;
+    int frameSizeBytesInp = 0;
+
+    bool isIQ = false;
+    float carrierInp_hz = 0.0f;
+
+    int nBytesPartial = 0;
+    int framesProcessed = 0;
+    int nFramesOffPitch = 0;
+
+    bool hasNewWaveform = false;
+    bool lastDecodeResult = false;
+    bool needRecompute = false;
+
+    ParametersDecode parametersDecode = getDefaultParametersDecode();
+
+    // the signal decoded outside of skimmer mode
+    Receiver receiver = {};
+
+    uint64_t timeFrontEnd_us = 0;
+    uint8_t bytesPartial[kMaxChannels*sizeof(double)] = {};
+
+    TxRx waveformTmp = {};
+    SignalF signalF = {};
 
-    STFFT stfft = {};
     Filter filterHighPass = {};
-    Filter filterLowPass = {};
-    Resampler resampler = {};
+    History history = {};
+    STFFT stfft = {};
+    FrontEnd frontEnd = {};
     GoertzelRunningFIR goertzelFilter = {};
+    ToneEnvelope toneEnvelope = {};
+
+    // I/Q input
+    IQFrontEnd iqFrontEnd = {};
+    History envelope = {};
+    SignalF envelopeF = {};
+
+    // skimmer mode
+    struct SkimmerSignal {
+        int id = 0;
+        int nFramesInactive = 0;
+        bool isNew = true;
+
+        // speed while the signal was last seen
+        float speed_wpm = 0.0f;
+
+        ToneEnvelope toneEnvelope = {};
+        Receiver receiver = {};
+    };
+
+    int skimmerNextId = 0;
+    float skimmerPeaks[kMaxSkimmerSignals] = {};
+    std::vector<SkimmerSignal> skimmerSignals = {};
+    std::vector<SkimmerData> skimmerStopped = {};
 
-    TAlphabet alphabet = kMorseCode;
+    const Codebook * codebook = &kMorseCode;
+    std::unique_ptr<Codebook> codebookModified = {};
+
+    // one decoder per channel in GGMORSE_CHANNEL_MODE_INDEPENDENT
+    std::vector<std::unique_ptr<GGMorseDecoder>> channelDecoders = {};
 };
 
-const GGMorse::Parameters & GGMorse::getDefaultParameters() {
+const GGMorseCommon::Parameters & GGMorseCommon::getDefaultParameters() {
     static ggmorse_Parameters result {
         kBaseSampleRate,
         kBaseSampleRate,
         kDefaultSamplesPerFrame,
         GGMORSE_SAMPLE_FORMAT_F32,
         GGMORSE_SAMPLE_FORMAT_F32,
+        1,
+        GGMORSE_CHANNEL_MODE_SELECT,
+        0,
+        GGMORSE_INPUT_MODE_AUDIO,
+        0.0f,
     };
 
     return result;
 }
 
-const GGMorse::ParametersDecode & GGMorse::getDefaultParametersDecode() {
+const GGMorseCommon::ParametersDecode & GGMorseCommon::getDefaultParametersDecode() {
     static ggmorse_ParametersDecode result {
         -1.0f,
         -1.0f,
@@ -193,43 +442,103 @@ const GGMorse::ParametersDecode & GGMorse::getDefaultParametersDecode() {
         1200.0f,
         true,
         true,
+        GGMORSE_TONE_DETECTOR_GOERTZEL,
+        false,
     };
 
     return result;
 }
 
-const GGMorse::ParametersEncode & GGMorse::getDefaultParametersEncode() {
+const GGMorseCommon::ParametersEncode & GGMorseCommon::getDefaultParametersEncode() {
     static ggmorse_ParametersEncode result {
         10,
         550.0f,
         25.0f,
         25.0f,
+        false,
     };
 
     return result;
 }
 
-GGMorse::GGMorse(const Parameters & parameters)
+GGMorseEncoder::GGMorseEncoder(const Parameters & parameters)
     : m_impl(new Impl({
-        parameters.sampleRateInp,
         parameters.sampleRateOut,
-        parameters.samplesPerFrame,
-        bytesForSampleFormat(parameters.sampleFormatInp),
         bytesForSampleFormat(parameters.sampleFormatOut),
-        parameters.sampleFormatInp,
         parameters.sampleFormatOut,
+    })) {
+}
+
+GGMorseEncoder::~GGMorseEncoder() {
+}
+
+GGMorseDecoder::GGMorseDecoder(const Parameters & parameters)
+    : m_impl(new Impl({
+        parameters.sampleRateInp,
         parameters.samplesPerFrame,
+        bytesForSampleFormat(parameters.sampleFormatInp),
+        parameters.sampleFormatInp,
     })) {
 
-    m_impl->intervalsAll.resize(100);
-    for (auto & intervals : m_impl->intervalsAll) {
-        intervals.resize(100);
-        for (auto & x : intervals) {
-            x.reserve(100);
+    m_impl->receiver.rxData.reserve(1024);
+
+    m_impl->frontEnd.init(parameters.sampleFormatInp, m_impl->sampleSizeBytesInp, parameters.sampleRateInp, kBaseSampleRate);
+    m_impl->frontEnd.initFilter(m_impl->parametersDecode.frequencyRangeMax_hz, kFilterOrderLowPass);
+    m_impl->filterHighPass.init(Filter::ButterworthHighPass, m_impl->parametersDecode.frequencyRangeMin_hz, kBaseSampleRate, kFilterOrderHighPass);
+
+    if (parameters.inputModeInp == GGMORSE_INPUT_MODE_IQ) {
+        if (parameters.sampleRateInp < kBaseSampleRate) {
+            fprintf(stderr, "I/Q sample rate must be at least %g: %g\n", kBaseSampleRate, parameters.sampleRateInp);
+            return;
+        }
+
+        if (parameters.samplesPerFrame % IQFrontEnd::kDownsample != 0) {
+            fprintf(stderr, "Samples per frame must be a multiple of %d for I/Q input: %d\n", IQFrontEnd::kDownsample, parameters.samplesPerFrame);
+            return;
         }
+
+        // the envelope covers the same time window as the audio envelope
+        const int nEnvelope = int(kMaxWindowToAnalyze_s*kBaseSampleRate)/IQFrontEnd::kDownsample;
+
+        m_impl->isIQ = true;
+        m_impl->carrierInp_hz = parameters.carrierInp_hz;
+        m_impl->channelsInp = 2;
+        m_impl->frameSizeBytesInp = 2*m_impl->sampleSizeBytesInp;
+        m_impl->iqFrontEnd.init(parameters.sampleFormatInp, m_impl->sampleSizeBytesInp, parameters.sampleRateInp, kBaseSampleRate, parameters.carrierInp_hz);
+        m_impl->iqFrontEnd.initFilter(kBandwidthIQ_hz, kFilterOrderIQ);
+        m_impl->envelope.init(nEnvelope, 0);
+        m_impl->envelopeF.resize(nEnvelope);
+
+        return;
     }
 
-    m_impl->rxData.reserve(1024);
+    const int channels = std::max(1, parameters.channelsInp);
+    if (channels > kMaxChannels) {
+        fprintf(stderr, "Invalid number of channels: %d\n", channels);
+        return;
+    }
+
+    if (parameters.channelModeInp == GGMORSE_CHANNEL_MODE_SELECT && (parameters.channelInp < 0 || parameters.channelInp >= channels)) {
+        fprintf(stderr, "Invalid channel: %d\n", parameters.channelInp);
+        return;
+    }
+
+    m_impl->channelsInp = channels;
+    m_impl->frameSizeBytesInp = channels*m_impl->sampleSizeBytesInp;
+    m_impl->frontEnd.initChannels(channels, parameters.channelModeInp == GGMORSE_CHANNEL_MODE_DOWNMIX, parameters.channelInp);
+
+    if (parameters.channelModeInp == GGMORSE_CHANNEL_MODE_INDEPENDENT && channels > 1) {
+        for (int i = 0; i < channels; ++i) {
+            auto parametersChannel = parameters;
+            parametersChannel.channelModeInp = GGMORSE_CHANNEL_MODE_SELECT;
+            parametersChannel.channelInp = i;
+
+            m_impl->channelDecoders.emplace_back(new GGMorseDecoder(parametersChannel));
+        }
+
+        // the channel decoders do all of the analysis
+        return;
+    }
 
     int pow2For10Hz = 1;
     while (pow2For10Hz < kBaseSampleRate/10) pow2For10Hz *= 2;
@@ -237,23 +546,42 @@ GGMorse::GGMorse(const Parameters & parameters)
     int pow2For50Hz = 1;
     while (pow2For50Hz < kBaseSampleRate/50) pow2For50Hz *= 2;
 
+    // the analysis stages read windows of up to pow2For10Hz samples from the shared history
+    m_impl->history.init(kMaxWindowToAnalyze_s*kBaseSampleRate, std::max(pow2For10Hz, pow2For50Hz));
     m_impl->stfft.init(kBaseSampleRate, pow2For10Hz, parameters.samplesPerFrame, kMaxWindowToAnalyze_s);
-    m_impl->filterHighPass.init(Filter::FirstOrderHighPass, m_impl->parametersDecode.frequencyRangeMin_hz, kBaseSampleRate);
-    m_impl->filterLowPass.init(Filter::FirstOrderLowPass, m_impl->parametersDecode.frequencyRangeMax_hz, m_impl->sampleRateInp);
     m_impl->goertzelFilter.init(kBaseSampleRate, pow2For50Hz, kMaxWindowToAnalyze_s);
+    m_impl->toneEnvelope.init(kBaseSampleRate, kMaxWindowToAnalyze_s);
 }
 
-GGMorse::~GGMorse() {
+GGMorseDecoder::~GGMorseDecoder() {
 }
 
-bool GGMorse::setParametersDecode(const ParametersDecode & parameters) {
+bool GGMorseDecoder::setParametersDecode(const ParametersDecode & parameters) {
     // todo : validate parameters
 
+    for (auto & decoder : m_impl->channelDecoders) {
+        decoder->setParametersDecode(parameters);
+    }
+
     if (m_impl->parametersDecode.frequencyRangeMin_hz != parameters.frequencyRangeMin_hz) {
-        m_impl->filterHighPass.init(Filter::FirstOrderHighPass, m_impl->parametersDecode.frequencyRangeMin_hz, kBaseSampleRate);
+        m_impl->filterHighPass.init(Filter::ButterworthHighPass, parameters.frequencyRangeMin_hz, kBaseSampleRate, kFilterOrderHighPass);
     }
     if (m_impl->parametersDecode.frequencyRangeMax_hz != parameters.frequencyRangeMax_hz) {
-        m_impl->filterLowPass.init(Filter::FirstOrderLowPass, m_impl->parametersDecode.frequencyRangeMax_hz, m_impl->sampleRateInp);
+        m_impl->frontEnd.initFilter(parameters.frequencyRangeMax_hz, kFilterOrderLowPass);
+    }
+    if (m_impl->parametersDecode.toneDetector != parameters.toneDetector) {
+        // the other detector has not been kept up to date
+        m_impl->needRecompute = true;
+    }
+    if (m_impl->parametersDecode.skimmer != parameters.skimmer) {
+        // the single-signal detector is not updated in skimmer mode
+        m_impl->needRecompute = true;
+
+        for (auto & signal : m_impl->skimmerSignals) {
+            m_impl->skimmerStopped.push_back({ signal.id, signal.toneEnvelope.frequency(),
+                signal.speed_wpm, false, std::move(signal.receiver.rxData) });
+        }
+        m_impl->skimmerSignals.clear();
     }
 
     m_impl->parametersDecode = parameters;
@@ -261,7 +589,7 @@ bool GGMorse::setParametersDecode(const ParametersDecode & parameters) {
     return true;
 }
 
-bool GGMorse::setParametersEncode(const ParametersEncode & parameters) {
+bool GGMorseEncoder::setParametersEncode(const ParametersEncode & parameters) {
     // todo : validate parameters
 
     if (parameters.volume < 0.0f || parameters.volume > 1.0f) {
@@ -277,470 +605,786 @@ bool GGMorse::setParametersEncode(const ParametersEncode & parameters) {
     return true;
 }
 
-bool GGMorse::init(int dataSize, const char * dataBuffer) {
+bool GGMorseEncoder::init(int dataSize, const char * dataBuffer) {
     if (dataSize < 0) {
         fprintf(stderr, "Negative data size: %d\n", dataSize);
         return false;
     }
 
-    if (dataSize > kMaxTxLength) {
-        fprintf(stderr, "Truncating data from %d to %d bytes\n", dataSize, kMaxTxLength);
-        dataSize = kMaxTxLength;
-    }
-
     m_impl->txDataLength = dataSize;
 
     const uint8_t * text = reinterpret_cast<const uint8_t *>(dataBuffer);
 
     m_impl->hasNewTxData = false;
-    m_impl->txData.resize(m_impl->txDataLength);
+    m_impl->txData.assign(text, text + m_impl->txDataLength);
 
-    if (m_impl->txDataLength > 0) {
-        for (int i = 0; i < m_impl->txDataLength; ++i) m_impl->txData[i] = text[i];
+    m_impl->txPos = 0;
+    m_impl->iSymbol = 0;
+    m_impl->nSymbolSamplesLeft = 0;
+    m_impl->txSample = 0;
+    m_impl->factorCur = 0.0f;
+    m_impl->symbols.clear();
+    m_impl->txWaveformI16.clear();
 
+    m_impl->isGapPending = false;
+    m_impl->nIdleSamples = 0;
+
+    if (m_impl->txDataLength > 0 || m_impl->isKeyer) {
         m_impl->hasNewTxData = true;
     }
 
     return true;
 }
 
-bool GGMorse::encode(const CBWaveformOut & cbWaveformOut) {
+bool GGMorseEncoder::append(int dataSize, const char * dataBuffer) {
+    if (dataSize < 0) {
+        fprintf(stderr, "Negative data size: %d\n", dataSize);
+        return false;
+    }
+
     if (m_impl->hasNewTxData == false) {
+        return init(dataSize, dataBuffer);
+    }
+
+    if (m_impl->isKeyer == false && m_impl->txPos > m_impl->txDataLength) {
+        fprintf(stderr, "The end of the message has already been sent\n");
         return false;
     }
 
-    m_impl->hasNewTxData = false;
+    // drop the characters that have been sent - only the cursor refers to the message
+    const int nSent = std::max(0, m_impl->txPos - 1);
+    m_impl->txData.erase(m_impl->txData.begin(), m_impl->txData.begin() + nSent);
+    m_impl->txPos -= nSent;
 
-    int nSamplesTotal = 0;
-
-    int lendot0_samples = m_impl->sampleRateOut*(1e-3*lendot_ms(m_impl->parametersEncode.speedCharacters_wpm));
-    int lendot1_samples = m_impl->sampleRateOut*(1e-3*lendot_ms(m_impl->parametersEncode.speedFarnsworth_wpm));
-
-    int lenLetterSpace_samples = 3.0f*lendot1_samples;
-    int lenWordSpace_samples = 7.0f*lendot1_samples;
-
-    // 0 - dot
-    // 1 - dash
-    // 2 - pause between symbols
-    // 3 - pause between letters
-    // 4 - pause between words
-    std::string symbols0;
-    std::string symbols1;
-
-    // start transmission with an empty signal
-    nSamplesTotal += lendot1_samples;
-    symbols0 += "2";
-    symbols1 += "";
-
-    for (int i = 0; i < m_impl->txDataLength; ++i) {
-        for (const auto & l : m_impl->alphabet) {
-            if (l.second == toUpper(m_impl->txData[i])) {
-                for (int k = 0; k < (int) l.first.size(); ++k) {
-                    if (l.first[k] == '0') {
-                        nSamplesTotal += 1*lendot0_samples;
-                        symbols0 += "0";
-                        symbols1 += ".";
-                    }
-                    if (l.first[k] == '1') {
-                        nSamplesTotal += 3*lendot0_samples;
-                        symbols0 += "1";
-                        symbols1 += "-";
-                    }
-                    if (k < (int) l.first.size() - 1) {
-                        nSamplesTotal += lendot1_samples;
-                        symbols0 += "2";
-                        symbols1 += "";
-                    }
-                }
-                break;
-            }
+    const uint8_t * text = reinterpret_cast<const uint8_t *>(dataBuffer);
+
+    m_impl->txData.insert(m_impl->txData.end(), text, text + dataSize);
+    m_impl->txDataLength = (int) m_impl->txData.size();
+
+    return true;
+}
+
+bool GGMorseEncoder::setKeyer(bool enabled) {
+    m_impl->isKeyer = enabled;
+
+    if (enabled && m_impl->hasNewTxData == false) {
+        return init(0, nullptr);
+    }
+
+    return true;
+}
+
+uint32_t GGMorseEncoder::encodeSize_bytes() const {
+    return encodeSize_samples()*m_impl->sampleSizeBytesOut;
+}
+
+uint32_t GGMorseEncoder::encodeSize_samples() const {
+    if (m_impl->txDataLength == 0) {
+        return 0;
+    }
+
+    const uint64_t result = transmissionSize_samples(*m_impl->codebook, m_impl->parametersEncode, m_impl->sampleRateOut, m_impl->txData);
+
+    // the size in bytes has to fit too
+    if (result*m_impl->sampleSizeBytesOut > std::numeric_limits<uint32_t>::max()) {
+        return 0;
+    }
+
+    return (uint32_t) result;
+}
+
+bool GGMorseEncoder::encode(const CBWaveformOut & cbWaveformOut) {
+    if (m_impl->hasNewTxData == false) {
+        return false;
+    }
+
+    if (convertFromFloat(m_impl->sampleFormatOut) == nullptr) {
+        return false;
+    }
+
+    m_impl->outputBlockTmp.resize(kEncodeChunkSamples*m_impl->sampleSizeBytesOut);
+
+    // output generated data via the provided callback
+    while (m_impl->hasNewTxData) {
+        const uint32_t nBytes = encode(m_impl->outputBlockTmp.data(), (uint32_t) m_impl->outputBlockTmp.size());
+        if (nBytes == 0) {
+            break;
         }
 
-        if (i < m_impl->txDataLength - 1) {
-            if (m_impl->txData[i] != ' ') {
-                if (m_impl->txData[i + 1] != ' ') {
-                    nSamplesTotal += lenLetterSpace_samples;
-                    symbols0 += "3";
-                    symbols1 += " ";
-                } else {
-                    nSamplesTotal += lenWordSpace_samples;
-                    symbols0 += "4";
-                    symbols1 += " / ";
-                }
-            }
+        cbWaveformOut(m_impl->outputBlockTmp.data(), nBytes);
+
+        // in keyer mode, up to the end of the text appended so far
+        const auto & impl = *m_impl;
+        if (impl.isKeyer && impl.txPos > impl.txDataLength && impl.iSymbol == (int) impl.symbols.size() && impl.nSymbolSamplesLeft == 0) {
+            break;
         }
     }
 
-    // finish transmission with an empty signal
-    nSamplesTotal += lendot1_samples;
-    symbols0 += "2";
-    symbols1 += "";
-
-    m_impl->outputBlockF.resize(nSamplesTotal);
-
-    int idx = 0;
-    float factorCur = 0.0;
-    const auto dampFactor = 1.0f/std::max(1.0f, 0.1f*lendot0_samples);
-    const auto & volume = m_impl->parametersEncode.volume;
-    const auto & frequency_hz = m_impl->parametersEncode.frequency_hz;
-    for (const char & s : symbols0) {
-        if (s == '0') {
-            for (int i = 0; i < lendot0_samples; ++i) {
-                m_impl->outputBlockF[idx] = factorCur*volume*std::sin((2.0*M_PI)*(idx*frequency_hz/m_impl->sampleRateOut));
-                factorCur = std::min(1.0f, factorCur + dampFactor);
-                ++idx;
-            }
+    return true;
+}
+
+uint32_t GGMorseEncoder::encode(void * data, uint32_t nMaxBytes) {
+    if (m_impl->hasNewTxData == false || m_impl->sampleSizeBytesOut == 0) {
+        return 0;
+    }
+
+    const auto convert = convertFromFloat(m_impl->sampleFormatOut);
+    if (convert == nullptr) {
+        return 0;
+    }
+
+    m_impl->outputBlockF.resize(kEncodeChunkSamples);
+
+    uint8_t * dst = reinterpret_cast<uint8_t *>(data);
+
+    // 32-bit float output is synthesized in place, the other formats through a small buffer that stays in the cache
+    const bool isInPlace = m_impl->sampleFormatOut == GGMORSE_SAMPLE_FORMAT_F32 && reinterpret_cast<uintptr_t>(data) % alignof(float) == 0;
+
+    const uint32_t nMaxSamples = nMaxBytes/m_impl->sampleSizeBytesOut;
+    uint32_t nSamplesTotal = 0;
+    while (nSamplesTotal < nMaxSamples && m_impl->hasNewTxData) {
+        uint8_t * out = dst + nSamplesTotal*m_impl->sampleSizeBytesOut;
+        float * outF = isInPlace ? reinterpret_cast<float *>(out) : m_impl->outputBlockF.data();
+
+        const int nSamples = encode_samples(outF, std::min<uint32_t>(kEncodeChunkSamples, nMaxSamples - nSamplesTotal));
+        if (isInPlace == false) {
+            convert(outF, out, nSamples);
         }
-        if (s == '1') {
-            for (int i = 0; i < 3*lendot0_samples; ++i) {
-                m_impl->outputBlockF[idx] = factorCur*volume*std::sin((2.0*M_PI)*(idx*frequency_hz/m_impl->sampleRateOut));
-                factorCur = std::min(1.0f, factorCur + dampFactor);
-                ++idx;
-            }
+
+        if (m_impl->parametersEncode.keepWaveformI16) {
+            const size_t offset = m_impl->txWaveformI16.size();
+            m_impl->txWaveformI16.resize(offset + nSamples);
+            convertFromFloat(GGMORSE_SAMPLE_FORMAT_I16)(outF, m_impl->txWaveformI16.data() + offset, nSamples);
         }
-        if (s == '2') {
-            for (int i = 0; i < lendot1_samples; ++i) {
-                m_impl->outputBlockF[idx] = factorCur*volume*std::sin((2.0*M_PI)*(idx*frequency_hz/m_impl->sampleRateOut));
-                factorCur = std::max(0.0f, factorCur - dampFactor);
-                ++idx;
+
+        nSamplesTotal += nSamples;
+    }
+
+    return nSamplesTotal*m_impl->sampleSizeBytesOut;
+}
+
+bool GGMorseEncoder::encode_symbols() {
+    auto & impl = *m_impl;
+
+    impl.symbols.clear();
+    impl.iSymbol = 0;
+
+    if (impl.txPos > impl.txDataLength + 1) {
+        return false;
+    }
+
+    if (impl.txPos == 0) {
+        // the timing is fixed for the whole transmission
+        impl.timing.init(impl.parametersEncode, impl.sampleRateOut);
+
+        impl.oscillator.init(impl.parametersEncode.frequency_hz, impl.sampleRateOut);
+
+        impl.elementTemplatesCur = nullptr;
+        for (const auto & cur : impl.elementTemplates) {
+            if (isSameEncode(cur->parameters, impl.parametersEncode)) {
+                impl.elementTemplatesCur = cur.get();
+                break;
             }
         }
-        if (s == '3') {
-            for (int i = 0; i < lenLetterSpace_samples; ++i) {
-                m_impl->outputBlockF[idx] = factorCur*volume*std::sin((2.0*M_PI)*(idx*frequency_hz/m_impl->sampleRateOut));
-                factorCur = std::max(0.0f, factorCur - dampFactor);
-                ++idx;
+
+        if (impl.elementTemplatesCur == nullptr) {
+            if ((int) impl.elementTemplates.size() == kMaxElementTemplates) {
+                impl.elementTemplates.erase(impl.elementTemplates.begin());
             }
-        }
-        if (s == '4') {
-            for (int i = 0; i < lenWordSpace_samples; ++i) {
-                m_impl->outputBlockF[idx] = factorCur*volume*std::sin((2.0*M_PI)*(idx*frequency_hz/m_impl->sampleRateOut));
-                factorCur = std::max(0.0f, factorCur - dampFactor);
-                ++idx;
+
+            auto cur = std::make_unique<Impl::ElementTemplates>();
+            cur->parameters = impl.parametersEncode;
+
+            const auto & volume = impl.parametersEncode.volume;
+
+            std::vector<float> envelope(3*impl.timing.lendot0_samples);
+            for (int i = 0; i < (int) envelope.size(); ++i) {
+                envelope[i] = volume*std::min(1.0f, i*impl.timing.dampFactor);
+            }
+            cur->tone.init(envelope, impl.parametersEncode.frequency_hz, impl.sampleRateOut);
+
+            envelope.clear();
+            while (1.0f - envelope.size()*impl.timing.dampFactor > 0.0f) {
+                envelope.push_back(volume*(1.0f - envelope.size()*impl.timing.dampFactor));
             }
+            cur->decay.init(envelope, impl.parametersEncode.frequency_hz, impl.sampleRateOut);
+
+            impl.elementTemplatesCur = cur.get();
+            impl.elementTemplates.push_back(std::move(cur));
         }
-    }
 
-    // default output is in 16-bit signed int so we always compute it
-    m_impl->outputBlockI16.resize(nSamplesTotal);
-    for (int i = 0; i < nSamplesTotal; ++i) {
-        m_impl->outputBlockI16[i] = 32768*m_impl->outputBlockF[i];
-    }
+        // start transmission with an empty signal
+        impl.symbols += '2';
+    } else if (impl.txPos <= impl.txDataLength) {
+        const int i = impl.txPos - 1;
 
-    // convert from 32-bit float
-    m_impl->outputBlockTmp.resize(nSamplesTotal*m_impl->sampleSizeBytesOut);
-    switch (m_impl->sampleFormatOut) {
-        case GGMORSE_SAMPLE_FORMAT_UNDEFINED:
-            {
-                return false;
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_U8:
-            {
-                auto p = reinterpret_cast<uint8_t *>(m_impl->outputBlockTmp.data());
-                for (int i = 0; i < nSamplesTotal; ++i) {
-                    p[i] = 128*(m_impl->outputBlockF[i] + 1.0f);
-                }
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_I8:
-            {
-                auto p = reinterpret_cast<uint8_t *>(m_impl->outputBlockTmp.data());
-                for (int i = 0; i < nSamplesTotal; ++i) {
-                    p[i] = 128*m_impl->outputBlockF[i];
-                }
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_U16:
-            {
-                auto p = reinterpret_cast<uint16_t *>(m_impl->outputBlockTmp.data());
-                for (int i = 0; i < nSamplesTotal; ++i) {
-                    p[i] = 32768*(m_impl->outputBlockF[i] + 1.0f);
-                }
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_I16:
-            {
-                // skip because we already have the data in m_impl->outputBlockI16
-                //auto p = reinterpret_cast<uint16_t *>(m_impl->outputBlockTmp.data());
-                //for (int i = 0; i < nSamplesTotal; ++i) {
-                //    p[i] = 32768*m_impl->outputBlockF[i];
-                //}
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_F32:
-            {
-                auto p = reinterpret_cast<float *>(m_impl->outputBlockTmp.data());
-                for (int i = 0; i < nSamplesTotal; ++i) {
-                    p[i] = m_impl->outputBlockF[i];
-                }
-            } break;
-    }
+        if (impl.isGapPending) {
+            const int nGap = impl.timing.length(impl.txData[i] != ' ' ? '3' : '4');
+            impl.nGapSamples = std::max(0, nGap - impl.nIdleSamples);
+            impl.symbols += '5';
+            impl.isGapPending = false;
+        }
 
-    // output generated data via the provided callback
-    switch (m_impl->sampleFormatOut) {
-        case GGMORSE_SAMPLE_FORMAT_UNDEFINED:
-            {
-                return false;
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_I16:
-            {
-                cbWaveformOut(m_impl->outputBlockI16.data(), nSamplesTotal*m_impl->sampleSizeBytesOut);
-            } break;
-        case GGMORSE_SAMPLE_FORMAT_U8:
-        case GGMORSE_SAMPLE_FORMAT_I8:
-        case GGMORSE_SAMPLE_FORMAT_U16:
-        case GGMORSE_SAMPLE_FORMAT_F32:
-            {
-                cbWaveformOut(m_impl->outputBlockTmp.data(), nSamplesTotal*m_impl->sampleSizeBytesOut);
-            } break;
-    }
+        const int nBytes = appendSymbols(*impl.codebook, impl.txData, i, impl.symbols);
 
-    m_impl->txWaveformI16.resize(nSamplesTotal);
-    for (int i = 0; i < nSamplesTotal; ++i) {
-        m_impl->txWaveformI16[i] = m_impl->outputBlockI16[i];
+        if (impl.isKeyer && i + nBytes == impl.txDataLength && impl.txData[i] != ' ') {
+            impl.isGapPending = true;
+            impl.nIdleSamples = 0;
+        }
+
+        impl.txPos += nBytes - 1;
+    } else {
+        // finish transmission with an empty signal
+        impl.symbols += '2';
+        impl.isGapPending = false;
     }
 
+    ++impl.txPos;
+
     return true;
 }
 
-bool GGMorse::decode(const CBWaveformInp & cbWaveformInp) {
-    bool result = false;
-    while (m_impl->hasNewTxData == false) {
-        const auto tStart_us = t_us();
+int GGMorseEncoder::encode_samples(float * dst, int nSamples) {
+    auto & impl = *m_impl;
+
+    const auto & volume = impl.parametersEncode.volume;
+
+    // the tone ramped from the current factor - up during dots and dashes and down during pauses
+    const auto generate = [&](float * out, int nCur, bool isTone) {
+        impl.oscillator.generate(out, nCur, impl.txSample);
+
+        const float factor0 = impl.factorCur;
+        const float dFactor = isTone ? impl.timing.dampFactor : -impl.timing.dampFactor;
+        for (int i = 0; i < nCur; ++i) {
+            out[i] *= volume*std::min(1.0f, std::max(0.0f, factor0 + i*dFactor));
+        }
+
+        impl.factorCur = std::min(1.0f, std::max(0.0f, factor0 + nCur*dFactor));
+    };
+
+    int n = 0;
+    while (n < nSamples) {
+        if (impl.nSymbolSamplesLeft == 0) {
+            if (impl.iSymbol < (int) impl.symbols.size()) {
+                const char symbol = impl.symbols[impl.iSymbol++];
+                impl.nSymbolSamplesLeft = symbol == '5' ? impl.nGapSamples : impl.timing.length(symbol);
+                impl.nSymbolSamples = impl.nSymbolSamplesLeft;
+                impl.factorSymbolStart = impl.factorCur;
+            } else if (impl.isKeyer && impl.txPos > impl.txDataLength) {
+                // nothing to send in keyer mode - the pause goes on until more text is appended
+                const int nCur = nSamples - n;
+
+                float * out = dst + n;
+                if (impl.factorCur == 0.0f) {
+                    std::fill(out, out + nCur, 0.0f);
+                } else {
+                    generate(out, nCur, false);
+                }
+
+                impl.nIdleSamples = std::min(impl.nIdleSamples + nCur, impl.timing.length('4'));
+                impl.txSample += nCur;
+                n += nCur;
+            } else if (encode_symbols() == false) {
+                impl.hasNewTxData = false;
+                break;
+            }
 
-        if (m_impl->samplesNeeded < m_impl->samplesPerFrame) {
-            m_impl->samplesNeeded += m_impl->samplesPerFrame;
+            continue;
         }
 
-        // read capture data
-        const float factor = m_impl->sampleRateInp/kBaseSampleRate;
-        uint32_t nBytesNeeded = m_impl->samplesNeeded*m_impl->sampleSizeBytesInp;
+        // the tone is ramped up during dots and dashes and down during pauses
+        const bool isTone = impl.symbols[impl.iSymbol - 1] == '0' || impl.symbols[impl.iSymbol - 1] == '1';
 
-        bool resampleSimple = false;
-        if (m_impl->sampleRateInp != kBaseSampleRate) {
-            if (int(m_impl->sampleRateInp) % int(kBaseSampleRate) == 0) {
-                nBytesNeeded *= factor;
-                resampleSimple = true;
+        const int nCur = std::min(nSamples - n, impl.nSymbolSamplesLeft);
+
+        const int offset = impl.nSymbolSamples - impl.nSymbolSamplesLeft;
+
+        // elements that start from silence or from the full tone match the templates - the others happen only
+        // with extreme Farnsworth timing and are synthesized directly
+        const auto & templates = *impl.elementTemplatesCur;
+        const bool useTemplate = isTone ? impl.factorSymbolStart == 0.0f : impl.factorSymbolStart == 1.0f;
+
+        float * out = dst + n;
+        if (isTone == false && impl.factorCur == 0.0f) {
+            std::fill(out, out + nCur, 0.0f);
+        } else if (useTemplate) {
+            const double phase = impl.oscillator.phase(impl.txSample - offset);
+            if (isTone) {
+                templates.tone.render(out, nCur, offset, phase);
+                impl.factorCur = std::min(1.0f, (offset + nCur)*impl.timing.dampFactor);
             } else {
-                nBytesNeeded = (m_impl->resampler.resample(1.0f/factor,
-                                                           m_impl->samplesNeeded,
-                                                           m_impl->waveformResampled.data(),
-                                                           nullptr))*m_impl->sampleSizeBytesInp;
+                const int nDecay = std::max(0, std::min(nCur, templates.decay.size() - offset));
+                templates.decay.render(out, nDecay, offset, phase);
+                std::fill(out + nDecay, out + nCur, 0.0f);
+                impl.factorCur = std::max(0.0f, 1.0f - (offset + nCur)*impl.timing.dampFactor);
             }
+        } else {
+            generate(out, nCur, isTone);
         }
 
-        uint32_t nBytesRecorded = 0;
-
-        switch (m_impl->sampleFormatInp) {
-            case GGMORSE_SAMPLE_FORMAT_UNDEFINED: break;
-            case GGMORSE_SAMPLE_FORMAT_U8:
-            case GGMORSE_SAMPLE_FORMAT_I8:
-            case GGMORSE_SAMPLE_FORMAT_U16:
-            case GGMORSE_SAMPLE_FORMAT_I16:
-                {
-                    nBytesRecorded = cbWaveformInp(m_impl->waveformTmp.data(), nBytesNeeded);
-                } break;
-            case GGMORSE_SAMPLE_FORMAT_F32:
-                {
-                    nBytesRecorded = cbWaveformInp(m_impl->waveformResampled.data(), nBytesNeeded);
-                } break;
+        impl.txSample += nCur;
+        n += nCur;
+        impl.nSymbolSamplesLeft -= nCur;
+    }
+
+    // report the end right after the last sample of the trailing pause
+    if (impl.nSymbolSamplesLeft == 0 && impl.iSymbol == (int) impl.symbols.size() && impl.txPos > impl.txDataLength + 1) {
+        impl.hasNewTxData = false;
+    }
+
+    return n;
+}
+
+bool GGMorseDecoder::decode(const CBWaveformInp & cbWaveformInp) {
+    bool result = false;
+    while (true) {
+        // request the capture data needed to complete the current frame
+        // the channel decoders all advance in lockstep, so the first one tells what is needed
+        const auto & impl = m_impl->channelDecoders.empty() ? *m_impl : *m_impl->channelDecoders[0]->m_impl;
+        const uint32_t nBytesNeeded = impl.isIQ ?
+            impl.iqFrontEnd.nSamplesNeeded(impl.samplesPerFrame/IQFrontEnd::kDownsample - impl.envelope.pending())*impl.frameSizeBytesInp :
+            impl.frontEnd.nSamplesNeeded(impl.samplesPerFrame - impl.history.pending())*impl.frameSizeBytesInp;
+
+        if (m_impl->waveformTmp.size() < nBytesNeeded) {
+            m_impl->waveformTmp.resize(nBytesNeeded);
         }
 
+        const uint32_t nBytesRecorded = cbWaveformInp(m_impl->waveformTmp.data(), nBytesNeeded);
+
         if (nBytesRecorded == 0) {
             break;
         }
 
-        if (nBytesRecorded % m_impl->sampleSizeBytesInp != 0) {
-            fprintf(stderr, "Failure during capture - provided bytes (%d) are not multiple of sample size (%d)\n",
-                    nBytesRecorded, m_impl->sampleSizeBytesInp);
-            m_impl->samplesNeeded = m_impl->samplesPerFrame;
+        if (nBytesRecorded > nBytesNeeded) {
+            fprintf(stderr, "Failure during capture - more bytes were provided (%d) than requested (%d)\n",
+                    nBytesRecorded, nBytesNeeded);
             break;
         }
 
-        if (nBytesRecorded > 0 && nBytesRecorded < nBytesNeeded) {
-            fprintf(stderr, "Failure during capture - less samples were provided (%d) than requested (%d)\n",
-                    nBytesRecorded/m_impl->sampleSizeBytesInp, nBytesNeeded/m_impl->sampleSizeBytesInp);
-            m_impl->samplesNeeded = m_impl->samplesPerFrame;
-            break;
+        if (decode(m_impl->waveformTmp.data(), nBytesRecorded)) {
+            result = true;
         }
 
-        if (nBytesRecorded > nBytesNeeded) {
-            fprintf(stderr, "Failure during capture - more samples were provided (%d) than requested (%d)\n",
-                    nBytesRecorded/m_impl->sampleSizeBytesInp, nBytesNeeded/m_impl->sampleSizeBytesInp);
-            m_impl->samplesNeeded = m_impl->samplesPerFrame;
+        // the capture has no more data for now - the incomplete frame is kept for the next call
+        if (nBytesRecorded < nBytesNeeded) {
             break;
         }
+    }
 
-        // convert to 32-bit float
-        int nSamplesRecorded = nBytesRecorded/m_impl->sampleSizeBytesInp;
-        switch (m_impl->sampleFormatInp) {
-            case GGMORSE_SAMPLE_FORMAT_UNDEFINED: break;
-            case GGMORSE_SAMPLE_FORMAT_U8:
-                {
-                    constexpr float scale = 1.0f/128;
-                    auto p = reinterpret_cast<uint8_t *>(m_impl->waveformTmp.data());
-                    for (int i = 0; i < nSamplesRecorded; ++i) {
-                        m_impl->waveformResampled[i] = float(int16_t(*(p + i)) - 128)*scale;
-                    }
-                } break;
-            case GGMORSE_SAMPLE_FORMAT_I8:
-                {
-                    constexpr float scale = 1.0f/128;
-                    auto p = reinterpret_cast<int8_t *>(m_impl->waveformTmp.data());
-                    for (int i = 0; i < nSamplesRecorded; ++i) {
-                        m_impl->waveformResampled[i] = float(*(p + i))*scale;
-                    }
-                } break;
-            case GGMORSE_SAMPLE_FORMAT_U16:
-                {
-                    constexpr float scale = 1.0f/32768;
-                    auto p = reinterpret_cast<uint16_t *>(m_impl->waveformTmp.data());
-                    for (int i = 0; i < nSamplesRecorded; ++i) {
-                        m_impl->waveformResampled[i] = float(int32_t(*(p + i)) - 32768)*scale;
-                    }
-                } break;
-            case GGMORSE_SAMPLE_FORMAT_I16:
-                {
-                    constexpr float scale = 1.0f/32768;
-                    auto p = reinterpret_cast<int16_t *>(m_impl->waveformTmp.data());
-                    for (int i = 0; i < nSamplesRecorded; ++i) {
-                        m_impl->waveformResampled[i] = float(*(p + i))*scale;
-                    }
-                } break;
-            case GGMORSE_SAMPLE_FORMAT_F32: break;
+    m_impl->lastDecodeResult = result;
+
+    return result;
+}
+
+bool GGMorseDecoder::decode(const void * data, size_t nBytes) {
+    bool result = false;
+
+    if (m_impl->channelDecoders.empty() == false) {
+        for (auto & decoder : m_impl->channelDecoders) {
+            if (decoder->decode(data, nBytes)) {
+                result = true;
+            }
         }
 
-        if (nSamplesRecorded == 0) {
-            break;
+        m_impl->lastDecodeResult = result;
+
+        return result;
+    }
+
+    // size of one sample with all of its channels
+    const int sampleSizeBytes = m_impl->frameSizeBytesInp;
+    if (sampleSizeBytes == 0) {
+        return false;
+    }
+
+    auto src = reinterpret_cast<const uint8_t *>(data);
+
+    // complete the sample that was split between the previous buffer and this one
+    if (m_impl->nBytesPartial > 0) {
+        const int n = (int) std::min(size_t(sampleSizeBytes - m_impl->nBytesPartial), nBytes);
+        std::copy(src, src + n, m_impl->bytesPartial + m_impl->nBytesPartial);
+        m_impl->nBytesPartial += n;
+
+        src += n;
+        nBytes -= n;
+
+        if (m_impl->nBytesPartial < sampleSizeBytes) {
+            m_impl->lastDecodeResult = false;
+            return false;
         }
 
-        uint32_t offset = m_impl->samplesNeeded > m_impl->samplesPerFrame ? 2*m_impl->samplesPerFrame - m_impl->samplesNeeded : 0;
+        result = decode_input(m_impl->bytesPartial, 1);
+        m_impl->nBytesPartial = 0;
+    }
 
-        if (m_impl->sampleRateInp != kBaseSampleRate) {
-            if (resampleSimple) {
-                if (m_impl->parametersDecode.applyFilterLowPass) {
-                    m_impl->filterLowPass.process(m_impl->waveformResampled.data(), nSamplesRecorded);
-                }
+    const size_t nSamples = nBytes/sampleSizeBytes;
 
-                int ds = int(factor);
-                int nSamplesResampled = 0;
-                for (int i = 0; i < nSamplesRecorded; i += ds) {
-                    m_impl->waveform[offset + nSamplesResampled] = m_impl->waveformResampled[i];
-                    ++nSamplesResampled;
-                }
-                nSamplesRecorded = offset + nSamplesResampled;
-            } else {
-                if (nSamplesRecorded <= 2*Resampler::kWidth) {
-                    fprintf(stderr, "Failure to resample data - provided samples (%d) are less than the allowed minimum (%d)\n",
-                            nSamplesRecorded, 2*Resampler::kWidth);
-                    m_impl->samplesNeeded = m_impl->samplesPerFrame;
-                    break;
-                }
+    if (decode_input(src, nSamples)) {
+        result = true;
+    }
 
-                // reset resampler state every minute
-                if (!m_impl->receivingData && m_impl->resampler.nSamplesTotal() > 60.0f*factor*kBaseSampleRate) {
-                    m_impl->resampler.reset();
-                }
+    // keep the bytes of an incomplete sample for the next call
+    m_impl->nBytesPartial = nBytes - nSamples*sampleSizeBytes;
+    std::copy(src + nSamples*sampleSizeBytes, src + nBytes, m_impl->bytesPartial);
+
+    m_impl->lastDecodeResult = result;
+
+    return result;
+}
+
+bool GGMorseDecoder::decode_input(const void * data, size_t nSamples) {
+    bool result = false;
+
+    auto src = reinterpret_cast<const uint8_t *>(data);
+
+    if (m_impl->isIQ) {
+        const int nFrame = m_impl->samplesPerFrame/IQFrontEnd::kDownsample;
+
+        while (nSamples > 0) {
+            const auto tStart_us = t_us();
+
+            auto & envelope = m_impl->envelope;
+
+            const int nSamplesFree = std::min(nFrame - envelope.pending(), envelope.writeAvailable());
+            const int n = (int) std::min(nSamples, size_t(m_impl->iqFrontEnd.nSamplesNeeded(nSamplesFree)));
+
+            // mix down, decimate and detect the envelope in a single pass, directly into the envelope ring
+            envelope.advance(m_impl->iqFrontEnd.process(src, n, envelope.writePtr()));
+
+            src += n*m_impl->frameSizeBytesInp;
+            nSamples -= n;
+
+            m_impl->timeFrontEnd_us += t_us() - tStart_us;
+
+            if (envelope.pending() == nFrame) {
+                m_impl->receiver.statistics.timeResample_ms = 1e-3*m_impl->timeFrontEnd_us;
+                m_impl->timeFrontEnd_us = 0;
+
+                m_impl->hasNewWaveform = true;
 
-                int nSamplesResampled = m_impl->resampler.resample(factor, nSamplesRecorded, m_impl->waveformResampled.data(), m_impl->waveform.data() + offset);
-                nSamplesRecorded = offset + nSamplesResampled;
+                decode_baseband();
+                result = true;
             }
+        }
+
+        return result;
+    }
+
+    while (nSamples > 0) {
+        // F32 input at the base sample rate: whole frames are analyzed directly from the caller's buffer
+        if (m_impl->history.pending() == 0 && nSamples >= size_t(m_impl->samplesPerFrame) &&
+            m_impl->frontEnd.isIdentity() && reinterpret_cast<uintptr_t>(src) % alignof(float) == 0) {
+            m_impl->receiver.statistics.timeResample_ms = 0.0f;
+
+            m_impl->hasNewWaveform = true;
+
+            decode_frame(reinterpret_cast<const float *>(src));
+            result = true;
+
+            src += m_impl->samplesPerFrame*m_impl->frameSizeBytesInp;
+            nSamples -= m_impl->samplesPerFrame;
+
+            continue;
+        }
+
+        const auto tStart_us = t_us();
+
+        // never process more input than is needed to complete the current frame
+        // or than fits before the end of the history ring
+        const int nSamplesFree = std::min(m_impl->samplesPerFrame - m_impl->history.pending(), m_impl->history.writeAvailable());
+        const int n = (int) std::min(nSamples, size_t(m_impl->frontEnd.nSamplesNeeded(nSamplesFree)));
+
+        // convert, band-limit and decimate to kBaseSampleRate in a single pass, directly into the history ring
+        m_impl->history.advance(m_impl->frontEnd.process(
+                src, n, m_impl->history.writePtr(), m_impl->parametersDecode.applyFilterLowPass));
+
+        src += n*m_impl->frameSizeBytesInp;
+        nSamples -= n;
+
+        m_impl->timeFrontEnd_us += t_us() - tStart_us;
+
+        // we have enough samples to do analysis
+        if (m_impl->history.pending() == m_impl->samplesPerFrame) {
+            m_impl->receiver.statistics.timeResample_ms = 1e-3*m_impl->timeFrontEnd_us;
+            m_impl->timeFrontEnd_us = 0;
+
+            m_impl->hasNewWaveform = true;
+
+            decode_frame(nullptr);
+            result = true;
+        }
+    }
+
+    return result;
+}
+
+void GGMorseDecoder::decode_frame(const float * frame) {
+    auto tStart_us = t_us();
+
+    auto filterHighPass = m_impl->parametersDecode.applyFilterHighPass ? &m_impl->filterHighPass : nullptr;
+
+    // the high-pass filter writes its output directly to the history
+    if (frame) {
+        m_impl->history.push(frame, m_impl->samplesPerFrame, filterHighPass);
+    } else {
+        m_impl->history.commit(filterHighPass);
+    }
+    m_impl->stfft.process(m_impl->history, m_impl->samplesPerFrame);
+
+    if (m_impl->parametersDecode.skimmer) {
+        decode_skimmer();
+
+        return;
+    }
+
+    auto frequency_hz = m_impl->parametersDecode.frequency_hz;
+
+    if (frequency_hz <= 0.0f) {
+        frequency_hz = m_impl->stfft.pitch(m_impl->parametersDecode.frequencyRangeMin_hz, m_impl->parametersDecode.frequencyRangeMax_hz);
+    }
+
+    int windowToAnalyze_samples = kMaxWindowToAnalyze_s*kBaseSampleRate;
+
+    const bool useGoertzel = m_impl->parametersDecode.toneDetector == GGMORSE_TONE_DETECTOR_GOERTZEL;
+    const bool useTracking = m_impl->parametersDecode.toneDetector == GGMORSE_TONE_DETECTOR_FLL;
+
+    m_impl->toneEnvelope.setTracking(useTracking);
+
+    if (useTracking && m_impl->needRecompute == false && m_impl->receiver.statistics.estimatedPitch_Hz > 0.0f) {
+        const auto & parameters = m_impl->parametersDecode;
+        const auto tracked_hz = m_impl->toneEnvelope.frequency();
+
+        // the loop follows the tone - the pitch estimate is only used to detect that it has lost it
+        // with a fixed frequency, the loop starts there and may only wander out of the decoded range
+        const bool isLost = parameters.frequency_hz > 0.0f ?
+            (tracked_hz < parameters.frequencyRangeMin_hz || tracked_hz > parameters.frequencyRangeMax_hz) :
+            std::fabs(frequency_hz - tracked_hz) > 50.0;
+
+        if (isLost) {
+            ++m_impl->nFramesOffPitch;
+        } else {
+            m_impl->nFramesOffPitch = 0;
+        }
+
+        if (m_impl->nFramesOffPitch < kFramesToReacquire) {
+            frequency_hz = tracked_hz;
+        } else {
+            m_impl->needRecompute = true;
+        }
+    }
+
+    // the recompute already covers the new samples in the history
+    bool isRecomputed = false;
+
+    if (std::fabs(frequency_hz - m_impl->receiver.statistics.estimatedPitch_Hz) > 50.0 || m_impl->needRecompute) {
+        if (useGoertzel) {
+            m_impl->goertzelFilter.recompute(m_impl->history, frequency_hz);
         } else {
-            for (int i = 0; i < nSamplesRecorded; ++i) {
-                m_impl->waveform[offset + i] = m_impl->waveformResampled[i];
+            m_impl->toneEnvelope.recompute(m_impl->history, frequency_hz);
+        }
+        m_impl->needRecompute = false;
+        m_impl->nFramesOffPitch = 0;
+        m_impl->receiver.rxData.push_back('\n');
+        m_impl->receiver.lastInterval = {};
+        m_impl->receiver.curLetter = {};
+        isRecomputed = true;
+    }
+
+    m_impl->receiver.statistics.timePitchDetection_ms = dt_ms(tStart_us);
+    m_impl->receiver.statistics.estimatedPitch_Hz = frequency_hz;
+
+    tStart_us = t_us();
+
+    if (useGoertzel == false) {
+        if (isRecomputed == false) {
+            m_impl->toneEnvelope.process(m_impl->history, m_impl->samplesPerFrame, frequency_hz);
+        }
+
+        m_impl->receiver.statistics.timeGoertzel_ms = dt_ms(tStart_us);
+
+        if (useTracking) {
+            m_impl->receiver.statistics.estimatedPitch_Hz = m_impl->toneEnvelope.frequency();
+        }
+
+        // the envelope is already at the rate of the analysis
+        decode_envelope(m_impl->toneEnvelope.filtered(), ToneEnvelope::kDecimation);
+
+        return;
+    }
+
+    if (isRecomputed == false) {
+        m_impl->goertzelFilter.process(m_impl->history, m_impl->samplesPerFrame, frequency_hz);
+    }
+
+    // todo : this is a copy
+    auto filteredF = m_impl->goertzelFilter.filtered();
+
+    // experimental filtering:
+    // noise below 200 Hz is eliminated
+    //auto filteredF = m_impl->goertzelFilter.filtered_min(kBaseSampleRate/200.0f);
+
+    int nSamples = (int) filteredF.size();
+
+    int nDownsample = 1;
+    while ((nSamples % 2 == 0) && (windowToAnalyze_samples > 500*kMaxWindowToAnalyze_s)) {
+        nDownsample *= 2;
+        nSamples /= 2;
+        windowToAnalyze_samples /= 2;
+    }
+
+    for (int i = 0; i < nSamples; ++i) {
+        float sum = 0.0;
+        for (int j = 0; j < nDownsample; ++j) {
+            sum += filteredF[i*nDownsample + j];
+        }
+        sum /= nDownsample;
+        filteredF[i] = sum;
+    }
+    filteredF.resize(nSamples);
+
+    m_impl->receiver.statistics.timeGoertzel_ms = dt_ms(tStart_us);
+
+    decode_envelope(filteredF, nDownsample);
+}
+
+void GGMorseDecoder::decode_baseband() {
+    auto tStart_us = t_us();
+
+    auto & envelope = m_impl->envelope;
+
+    envelope.commit();
+
+    // the whole envelope history, oldest sample first
+    auto & envelopeF = m_impl->envelopeF;
+    const int nTail = envelope.size() - envelope.head();
+    std::copy(envelope.view(envelope.head()), envelope.view(envelope.head()) + nTail, envelopeF.begin());
+    std::copy(envelope.view(0), envelope.view(0) + envelope.head(), envelopeF.begin() + nTail);
+
+    m_impl->receiver.statistics.timePitchDetection_ms = 0.0f;
+    m_impl->receiver.statistics.estimatedPitch_Hz = m_impl->carrierInp_hz;
+    m_impl->receiver.statistics.timeGoertzel_ms = dt_ms(tStart_us);
+
+    decode_envelope(envelopeF, IQFrontEnd::kDownsample);
+}
+
+void GGMorseDecoder::decode_skimmer() {
+    auto tStart_us = t_us();
+
+    const auto & parameters = m_impl->parametersDecode;
+    const int nFramesInWindow = int(kMaxWindowToAnalyze_s*kBaseSampleRate)/m_impl->samplesPerFrame;
+
+    auto & signals = m_impl->skimmerSignals;
+    auto & peaks = m_impl->skimmerPeaks;
+
+    // the spectrum average is not reliable until the spectrogram has been filled
+    int nPeaks = 0;
+    if (m_impl->framesProcessed >= nFramesInWindow/2) {
+        nPeaks = m_impl->stfft.peaks(parameters.frequencyRangeMin_hz, parameters.frequencyRangeMax_hz,
+                                     kSkimmerSpacing_hz, kSkimmerThreshold, peaks, kMaxSkimmerSignals);
+    }
+
+    for (auto & signal : signals) {
+        ++signal.nFramesInactive;
+    }
+
+    for (int i = 0; i < nPeaks; ++i) {
+        // the peak belongs to the nearest signal that is already being decoded
+        int nearest = -1;
+        float nearestDistance_hz = 0.5f*kSkimmerSpacing_hz;
+        for (int k = 0; k < (int) signals.size(); ++k) {
+            const float distance_hz = std::fabs(signals[k].toneEnvelope.frequency() - peaks[i]);
+            if (distance_hz < nearestDistance_hz) {
+                nearestDistance_hz = distance_hz;
+                nearest = k;
             }
         }
 
-        // we have enough bytes to do analysis
-        if (nSamplesRecorded >= m_impl->samplesPerFrame) {
-            m_impl->statistics.timeResample_ms = dt_ms(tStart_us);
-
-            while (nSamplesRecorded >= m_impl->samplesPerFrame) {
-                m_impl->hasNewWaveform = true;
+        if (nearest >= 0) {
+            auto & signal = signals[nearest];
+            signal.nFramesInactive = 0;
 
-                decode_float();
-                result = true;
+            if (nearestDistance_hz > kSkimmerTolerance_hz && signal.isNew == false) {
+                signal.toneEnvelope.recompute(m_impl->history, peaks[i]);
+                signal.receiver.lastInterval = {};
+                signal.receiver.curLetter = {};
+                signal.isNew = true;
+            }
 
-                int nExtraSamples = nSamplesRecorded - m_impl->samplesPerFrame;
-                for (int i = 0; i < nExtraSamples; ++i) {
-                    m_impl->waveform[i] = m_impl->waveform[m_impl->samplesPerFrame + i];
-                }
+            continue;
+        }
 
-                m_impl->samplesNeeded = m_impl->samplesPerFrame - nExtraSamples;
-                nSamplesRecorded -= m_impl->samplesPerFrame;
-            }
-        } else {
-            m_impl->samplesNeeded = m_impl->samplesPerFrame - nSamplesRecorded;
-            break;
+        if ((int) signals.size() >= kMaxSkimmerSignals) {
+            continue;
         }
-    }
 
-    m_impl->lastDecodeResult = result;
+        signals.emplace_back();
 
-    return result;
-}
+        auto & signal = signals.back();
+        signal.id = m_impl->skimmerNextId++;
+        signal.toneEnvelope.init(kBaseSampleRate, kMaxWindowToAnalyze_s);
+        signal.toneEnvelope.setTracking(parameters.toneDetector == GGMORSE_TONE_DETECTOR_FLL);
+        signal.toneEnvelope.recompute(m_impl->history, peaks[i]);
+    }
 
-void GGMorse::decode_float() {
-    auto tStart_us = t_us();
+    m_impl->receiver.statistics.timePitchDetection_ms = dt_ms(tStart_us);
+    m_impl->receiver.statistics.estimatedPitch_Hz = nPeaks > 0 ? peaks[0] : 0.0f;
 
-    if (m_impl->parametersDecode.applyFilterHighPass) {
-        m_impl->filterHighPass.process(m_impl->waveform.data(), m_impl->samplesPerFrame);
-    }
+    tStart_us = t_us();
 
-    m_impl->stfft.process(m_impl->waveform.data(), m_impl->samplesPerFrame);
+    for (auto & signal : signals) {
+        // a new signal has been computed over the whole history
+        if (signal.isNew == false) {
+            signal.toneEnvelope.process(m_impl->history, m_impl->samplesPerFrame, signal.toneEnvelope.frequency());
+        }
+        signal.isNew = false;
 
-    auto frequency_hz = m_impl->parametersDecode.frequency_hz;
-    auto speed_wpm    = m_impl->parametersDecode.speed_wpm;
+        decode_intervals(signal.toneEnvelope.filtered(), ToneEnvelope::kDecimation, signal.receiver);
 
-    if (frequency_hz <= 0.0f) {
-        frequency_hz = m_impl->stfft.pitch(m_impl->parametersDecode.frequencyRangeMin_hz, m_impl->parametersDecode.frequencyRangeMax_hz);
+        signal.receiver.statistics.estimatedPitch_Hz = signal.toneEnvelope.frequency();
+        if (signal.nFramesInactive == 0) {
+            signal.speed_wpm = signal.receiver.statistics.estimatedSpeed_wpm;
+        }
     }
 
-    int windowToAnalyze_samples = kMaxWindowToAnalyze_s*kBaseSampleRate;
+    // a signal is stopped one analysis window after it was last seen, so that its last letters get decoded
+    for (int k = 0; k < (int) signals.size(); ) {
+        auto & signal = signals[k];
+        if (signal.nFramesInactive <= nFramesInWindow) {
+            ++k;
+            continue;
+        }
 
-    if (std::fabs(frequency_hz - m_impl->statistics.estimatedPitch_Hz) > 50.0) {
-        m_impl->goertzelFilter.recompute(frequency_hz);
-        m_impl->rxData.push_back('\n');
-        m_impl->lastInterval = {};
-        m_impl->curLetter = "";
+        m_impl->skimmerStopped.push_back({ signal.id, signal.toneEnvelope.frequency(),
+            signal.speed_wpm, false, std::move(signal.receiver.rxData) });
+        signals.erase(signals.begin() + k);
     }
 
-    m_impl->statistics.timePitchDetection_ms = dt_ms(tStart_us);
-    m_impl->statistics.estimatedPitch_Hz = frequency_hz;
+    m_impl->receiver.statistics.timeFrameAnalysis_ms = dt_ms(tStart_us);
 
-    tStart_us = t_us();
+    ++m_impl->framesProcessed;
+}
 
-    m_impl->goertzelFilter.process(m_impl->waveform.data(), m_impl->samplesPerFrame, frequency_hz);
+void GGMorseDecoder::decode_envelope(const SignalF & filteredF, int nDownsample) {
+    decode_intervals(filteredF, nDownsample, m_impl->receiver);
 
-    // todo : this is a copy
-    auto filteredF = m_impl->goertzelFilter.filtered();
+    m_impl->signalF = filteredF;
 
-    // experimental filtering:
-    // noise below 200 Hz is eliminated
-    //auto filteredF = m_impl->goertzelFilter.filtered_min(kBaseSampleRate/200.0f);
+    ++m_impl->framesProcessed;
+}
 
-    int nSamples = (int) filteredF.size();
-    int nFramesInWindow = windowToAnalyze_samples/m_impl->samplesPerFrame;
+void GGMorseDecoder::decode_intervals(const SignalF & filteredF, int nDownsample, Receiver & receiver) {
+    auto tStart_us = t_us();
 
-    int nDownsample = 1;
-    while ((nSamples % 2 == 0) && (windowToAnalyze_samples > 500*kMaxWindowToAnalyze_s)) {
-        nDownsample *= 2;
-        nSamples /= 2;
-        windowToAnalyze_samples /= 2;
-    }
+    const auto speed_wpm = m_impl->parametersDecode.speed_wpm;
+
+    const int nSamples = (int) filteredF.size();
+    const int nFramesInWindow = int(kMaxWindowToAnalyze_s*kBaseSampleRate)/m_impl->samplesPerFrame;
 
     double mean = 0.0;
     for (int i = 0; i < nSamples; ++i) {
-        float sum = 0.0;
-        for (int j = 0; j < nDownsample; ++j) {
-            sum += filteredF[i*nDownsample + j];
-        }
-        sum /= nDownsample;
-        filteredF[i] = sum;
         mean += filteredF[i];
     }
     mean /= nSamples;
-    filteredF.resize(nSamples);
-
-    m_impl->statistics.timeGoertzel_ms = dt_ms(tStart_us);
-
-    tStart_us = t_us();
 
     float bestCost = 1e6;
     int bestLevelIdx = 0;
@@ -758,12 +1402,12 @@ void GGMorse::decode_float() {
 
     for (int mode = 0; mode < nModes; ++mode) {
         if (mode == 1) {
-            s0 = std::min(std::max(0.0f, std::round(m_impl->statistics.estimatedSpeed_wpm - 5.0f - 2.0f)), 50.0f);
-            s1 = std::min(std::max(0.0f, std::round(m_impl->statistics.estimatedSpeed_wpm - 5.0f + 2.0f)), 50.0f);
+            s0 = std::min(std::max(0.0f, std::round(receiver.statistics.estimatedSpeed_wpm - 5.0f - 2.0f)), 50.0f);
+            s1 = std::min(std::max(0.0f, std::round(receiver.statistics.estimatedSpeed_wpm - 5.0f + 2.0f)), 50.0f);
             ds = 1;
         }
 
-        int lOld = std::min(std::max(20.0f, 100.0f*m_impl->statistics.signalThreshold), 80.0f);
+        int lOld = std::min(std::max(20.0f, 100.0f*receiver.statistics.signalThreshold), 80.0f);
         int l0 = (mode == 0) ? 10 : lOld - 10;
         int l1 = (mode == 0) ? 90 : lOld + 10;
         int dl = (mode == 0) ? 20 : 2;
@@ -780,7 +1424,7 @@ void GGMorse::decode_float() {
                 curInterval.start = 0;
                 curInterval.avg = filteredF[0];
 
-                auto & intervals = m_impl->intervalsAll[s][l];
+                auto & intervals = receiver.intervals;
                 intervals.clear();
 
                 int nOnIntervals = 0;
@@ -924,35 +1568,37 @@ void GGMorse::decode_float() {
                     bestCost = curCost;
                     bestLevelIdx = l;
                     bestSpeedIdx = s;
+
+                    std::swap(receiver.intervals, receiver.intervalsBest);
                 }
             }
         }
     }
 
-    m_impl->statistics.timeFrameAnalysis_ms = dt_ms(tStart_us);
-    m_impl->statistics.costFunction = bestCost;
+    receiver.statistics.timeFrameAnalysis_ms = dt_ms(tStart_us);
+    receiver.statistics.costFunction = bestCost;
 
     {
         const bool isDecoding = bestCost < 1.0f;
-        const auto & intervals = m_impl->intervalsAll[bestSpeedIdx][bestLevelIdx];
+        const auto & intervals = receiver.intervalsBest;
 
         const float estimatedSpeed_wpm = 5 + bestSpeedIdx;
-        if (std::fabs(m_impl->statistics.estimatedSpeed_wpm - estimatedSpeed_wpm) > 2.0f) {
-            m_impl->nFramesWithCurSpeed = 0;
+        if (std::fabs(receiver.statistics.estimatedSpeed_wpm - estimatedSpeed_wpm) > 2.0f) {
+            receiver.nFramesWithCurSpeed = 0;
         }
-        m_impl->statistics.estimatedSpeed_wpm = estimatedSpeed_wpm;
-        ++m_impl->nFramesWithCurSpeed;
+        receiver.statistics.estimatedSpeed_wpm = estimatedSpeed_wpm;
+        ++receiver.nFramesWithCurSpeed;
 
-        m_impl->statistics.signalThreshold = 0.01*bestLevelIdx;
+        receiver.statistics.signalThreshold = 0.01*bestLevelIdx;
 
         int w0 = (2*nFramesInWindow/6);
         int w1 = (2*nFramesInWindow/6);
 
         if (estimatedSpeed_wpm >= 15.0f) {
-            if (m_impl->nFramesWithCurSpeed == nFramesInWindow) {
+            if (receiver.nFramesWithCurSpeed == nFramesInWindow) {
                 w1 = (5*nFramesInWindow)/6;
             }
-            if (m_impl->nFramesWithCurSpeed > nFramesInWindow) {
+            if (receiver.nFramesWithCurSpeed > nFramesInWindow) {
                 w0 = (5*nFramesInWindow)/6;
                 w1 = (5*nFramesInWindow)/6;
             }
@@ -965,69 +1611,88 @@ void GGMorse::decode_float() {
 
                 while (s >= intervals[j].end) ++j;
 
-                if (m_impl->lastInterval.signal != intervals[j].signal) {
+                if (receiver.lastInterval.signal != intervals[j].signal) {
                     if (isDecoding) {
                         if (intervals[j].signal == 1) {
-                            m_impl->curLetter += intervals[j].type == 1 ? "1" : "0";
+                            receiver.curLetter.push(intervals[j].type == 1);
                         } else {
                             if (intervals[j].type == 0 ||
                                 intervals[j].type == 2 ||
                                 intervals[j].type == 3) {
-                                if (auto let = m_impl->alphabet.find(m_impl->curLetter); let != m_impl->alphabet.end()) {
-                                    m_impl->rxData.push_back(let->second);
-                                    printf("%c", let->second);
+                                if (const auto & let = m_impl->codebook->decode(receiver.curLetter); let.length > 0) {
+                                    receiver.rxData.insert(receiver.rxData.end(), let.data, let.data + let.length);
                                 } else {
-                                    m_impl->rxData.push_back('?');
-                                    printf("?");
+                                    receiver.rxData.push_back('?');
                                 }
-                                fflush(stdout);
-                                m_impl->curLetter = "";
+                                receiver.curLetter = {};
                             }
                             {
                                 std::string tmp = intervals[j].type == 2 ? "" : intervals[j].type == 3 ? " " : intervals[j].type == 1 ? "" : " ";
                                 if (tmp.size()) {
-                                    m_impl->rxData.push_back(tmp[0]);
+                                    receiver.rxData.push_back(tmp[0]);
                                 }
-                                printf("%s", tmp.c_str());
                             }
                         }
                     }
-                    m_impl->lastInterval = intervals[j];
+                    receiver.lastInterval = intervals[j];
                 }
             }
         }
     }
+}
 
-    m_impl->signalF = filteredF;
+const bool & GGMorseEncoder::hasTxData() const { return m_impl->hasNewTxData; }
 
-    ++m_impl->framesProcessed;
+const int & GGMorseEncoder::getSampleSizeBytesOut() const { return m_impl->sampleSizeBytesOut; }
+const float & GGMorseEncoder::getSampleRateOut() const { return m_impl->sampleRateOut; }
+const GGMorseEncoder::SampleFormat & GGMorseEncoder::getSampleFormatOut() const { return m_impl->sampleFormatOut; }
+
+int GGMorseEncoder::takeTxWaveformI16(WaveformI16 & dst) {
+    if (m_impl->txWaveformI16.size() == 0) return false;
+
+    dst = std::move(m_impl->txWaveformI16);
+
+    return (int) dst.size();
+}
+
+bool GGMorseEncoder::setCharacter(const std::string & s01, char c) {
+    return setCharacter(s01, std::string(1, c));
+}
+
+bool GGMorseEncoder::setCharacter(const std::string & s01, const std::string & text) {
+    return setCodebookCharacter(m_impl->codebook, m_impl->codebookModified, s01, text);
 }
 
-const bool & GGMorse::hasTxData() const { return m_impl->hasNewTxData; }
-const bool & GGMorse::lastDecodeResult() const { return m_impl->lastDecodeResult; }
+const bool & GGMorseDecoder::lastDecodeResult() const { return m_impl->lastDecodeResult; }
+
+const int & GGMorseDecoder::getSamplesPerFrame() const { return m_impl->samplesPerFrame; }
+const int & GGMorseDecoder::getSampleSizeBytesInp() const { return m_impl->sampleSizeBytesInp; }
 
-const int & GGMorse::getSamplesPerFrame() const { return m_impl->samplesPerFrame; }
-const int & GGMorse::getSampleSizeBytesInp() const { return m_impl->sampleSizeBytesInp; }
-const int & GGMorse::getSampleSizeBytesOut() const { return m_impl->sampleSizeBytesOut; }
+const float & GGMorseDecoder::getSampleRateInp() const { return m_impl->sampleRateInp; }
+const GGMorseDecoder::SampleFormat & GGMorseDecoder::getSampleFormatInp() const { return m_impl->sampleFormatInp; }
+const int & GGMorseDecoder::getChannelsInp() const { return m_impl->channelsInp; }
+
+GGMorseDecoder * GGMorseDecoder::getChannelDecoder(int channel) {
+    if (channel < 0 || channel >= (int) m_impl->channelDecoders.size()) {
+        return nullptr;
+    }
 
-const float & GGMorse::getSampleRateInp() const { return m_impl->sampleRateInp; }
-const float & GGMorse::getSampleRateOut() const { return m_impl->sampleRateOut; }
-const GGMorse::SampleFormat & GGMorse::getSampleFormatInp() const { return m_impl->sampleFormatInp; }
-const GGMorse::SampleFormat & GGMorse::getSampleFormatOut() const { return m_impl->sampleFormatOut; }
+    return m_impl->channelDecoders[channel].get();
+}
 
-const GGMorse::TxRx & GGMorse::getRxData() const {
-    return m_impl->rxData;
+const GGMorseDecoder::TxRx & GGMorseDecoder::getRxData() const {
+    return m_impl->receiver.rxData;
 }
 
-int GGMorse::takeRxData(TxRx & dst) {
-    if (m_impl->rxData.size() == 0) return 0;
+int GGMorseDecoder::takeRxData(TxRx & dst) {
+    if (m_impl->receiver.rxData.size() == 0) return 0;
 
-    dst = std::move(m_impl->rxData);
+    dst = std::move(m_impl->receiver.rxData);
 
     return (int) dst.size();
 }
 
-int GGMorse::takeSignalF(SignalF & dst) {
+int GGMorseDecoder::takeSignalF(SignalF & dst) {
     if (m_impl->signalF.size() == 0) return 0;
 
     dst = std::move(m_impl->signalF);
@@ -1035,27 +1700,453 @@ int GGMorse::takeSignalF(SignalF & dst) {
     return (int) dst.size();
 }
 
-int GGMorse::takeTxWaveformI16(WaveformI16 & dst) {
-    if (m_impl->txWaveformI16.size() == 0) return false;
+int GGMorseDecoder::takeSkimmerData(std::vector<SkimmerData> & dst) {
+    dst = std::move(m_impl->skimmerStopped);
+    m_impl->skimmerStopped.clear();
 
-    dst = std::move(m_impl->txWaveformI16);
+    for (auto & signal : m_impl->skimmerSignals) {
+        if (signal.receiver.rxData.size() == 0) continue;
+
+        dst.push_back({ signal.id, signal.toneEnvelope.frequency(),
+            signal.speed_wpm, true, std::move(signal.receiver.rxData) });
+        signal.receiver.rxData.clear();
+    }
 
     return (int) dst.size();
 }
 
-const GGMorse::Statistics & GGMorse::getStatistics() const { return m_impl->statistics; }
-const GGMorse::Spectrogram GGMorse::getSpectrogram() const { return m_impl->stfft.spectrogram(); }
+const GGMorseDecoder::Statistics & GGMorseDecoder::getStatistics() const { return m_impl->receiver.statistics; }
+const GGMorseDecoder::Spectrogram GGMorseDecoder::getSpectrogram() const { return m_impl->stfft.spectrogram(); }
 
-bool GGMorse::setCharacter(const std::string & s01, char c) {
-    // remove old character
-    for (auto it : m_impl->alphabet) {
-        if (it.second == c) {
-            m_impl->alphabet.erase(it.first);
-            break;
+bool GGMorseDecoder::setCharacter(const std::string & s01, char c) {
+    return setCharacter(s01, std::string(1, c));
+}
+
+bool GGMorseDecoder::setCharacter(const std::string & s01, const std::string & text) {
+    if (setCodebookCharacter(m_impl->codebook, m_impl->codebookModified, s01, text) == false) {
+        return false;
+    }
+
+    for (auto & decoder : m_impl->channelDecoders) {
+        decoder->setCharacter(s01, text);
+    }
+
+    return true;
+}
+
+//
+// GGMorseBatchEncoder
+//
+
+struct GGMorseBatchEncoder::Impl {
+    // one per thread - the first one is used by the thread calling encode()
+    std::vector<std::unique_ptr<GGMorseEncoder>> encoders = {};
+    std::vector<std::thread> workers = {};
+
+    std::mutex mutex = {};
+    std::condition_variable cvStart = {};
+    std::condition_variable cvDone = {};
+
+    bool isRunning = true;
+    int batch = 0;
+    int nWorkersBusy = 0;
+
+    // the current batch - the messages are taken in order by the threads that are free
+    std::vector<Message> * messages = nullptr;
+    std::atomic<int> nextMessage = { 0 };
+    std::atomic<bool> result = { true };
+
+    void encode(GGMorseEncoder & encoder) {
+        const int nMessages = (int) messages->size();
+
+        for (int i = nextMessage++; i < nMessages; i = nextMessage++) {
+            auto & message = (*messages)[i];
+            message.nBytes = 0;
+
+            if (encoder.setParametersEncode(message.parameters) == false) {
+                result = false;
+                continue;
+            }
+
+            encoder.init((int) message.text.size(), message.text.data());
+
+            uint8_t * output = reinterpret_cast<uint8_t *>(message.output);
+            while (encoder.hasTxData() && message.nBytes < message.nMaxBytes) {
+                message.nBytes += encoder.encode(output + message.nBytes, message.nMaxBytes - message.nBytes);
+            }
+
+            if (encoder.hasTxData()) {
+                fprintf(stderr, "Output buffer of message %d is too small: %d bytes\n", i, (int) message.nMaxBytes);
+                result = false;
+            }
+        }
+    }
+
+    void work(GGMorseEncoder & encoder) {
+        int batchLast = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cvStart.wait(lock, [&]() { return isRunning == false || batch != batchLast; });
+                if (isRunning == false) {
+                    return;
+                }
+                batchLast = batch;
+            }
+
+            encode(encoder);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--nWorkersBusy == 0) {
+                    cvDone.notify_one();
+                }
+            }
+        }
+    }
+};
+
+GGMorseBatchEncoder::GGMorseBatchEncoder(const Parameters & parameters, int nThreads) : m_impl(new Impl()) {
+    if (nThreads <= 0) {
+        nThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < nThreads; ++i) {
+        m_impl->encoders.emplace_back(new GGMorseEncoder(parameters));
+    }
+
+    for (int i = 1; i < nThreads; ++i) {
+        m_impl->workers.emplace_back([this, i]() { m_impl->work(*m_impl->encoders[i]); });
+    }
+}
+
+GGMorseBatchEncoder::~GGMorseBatchEncoder() {
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->isRunning = false;
+    }
+    m_impl->cvStart.notify_all();
+
+    for (auto & worker : m_impl->workers) {
+        worker.join();
+    }
+}
+
+uint32_t GGMorseBatchEncoder::encodeSize_bytes(const Message & message) const {
+    // the encoders are not touched, so that a batch can be encoded at the same time
+    const auto & encoder = *m_impl->encoders[0];
+
+    if (message.text.empty() || message.parameters.volume < 0.0f || message.parameters.volume > 1.0f) {
+        return 0;
+    }
+
+    const TxRx txData(message.text.begin(), message.text.end());
+    const uint64_t result = transmissionSize_samples(kMorseCode, message.parameters, encoder.getSampleRateOut(), txData)*encoder.getSampleSizeBytesOut();
+
+    if (result > std::numeric_limits<uint32_t>::max()) {
+        return 0;
+    }
+
+    return (uint32_t) result;
+}
+
+bool GGMorseBatchEncoder::encode(std::vector<Message> & messages) {
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->messages = &messages;
+        m_impl->nextMessage = 0;
+        m_impl->result = true;
+        m_impl->nWorkersBusy = (int) m_impl->workers.size();
+        ++m_impl->batch;
+    }
+    m_impl->cvStart.notify_all();
+
+    m_impl->encode(*m_impl->encoders[0]);
+
+    {
+        std::unique_lock<std::mutex> lock(m_impl->mutex);
+        m_impl->cvDone.wait(lock, [&]() { return m_impl->nWorkersBusy == 0; });
+        m_impl->messages = nullptr;
+    }
+
+    return m_impl->result;
+}
+
+int GGMorseBatchEncoder::getThreads() const { return (int) m_impl->encoders.size(); }
+
+//
+// GGMorseDecoderPool
+//
+
+struct GGMorseDecoderPool::Impl {
+    // the queued audio of one decoder
+    struct Instance {
+        GGMorseDecoder * decoder = nullptr;
+
+        std::mutex mutex = {};
+        TxRx input = {};
+        size_t offset = 0;
+
+        // a task of the decoder is queued or running - there is at most one, so the frames are decoded in order
+        bool isScheduled = false;
+    };
+
+    // the tasks of one thread - it takes them from the front, the other threads steal them from the back
+    struct Queue {
+        std::mutex mutex = {};
+        std::deque<Instance *> tasks = {};
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues = {};
+    std::vector<std::thread> workers = {};
+
+    std::mutex mutex = {};
+    std::condition_variable cvTask = {};
+    std::condition_variable cvDone = {};
+
+    bool isRunning = true;
+
+    std::map<GGMorseDecoder *, std::unique_ptr<Instance>> instances = {};
+
+    std::atomic<int> nTasks = { 0 };
+    std::atomic<int> nIdle = { 0 };
+    std::atomic<int> nScheduled = { 0 };
+    int nextQueue = 0;
+
+    void push(Instance * instance, int iQueue) {
+        {
+            std::lock_guard<std::mutex> lock(queues[iQueue]->mutex);
+            queues[iQueue]->tasks.push_back(instance);
+        }
+
+        // a thread that is going to sleep either sees the task or is woken up
+        ++nTasks;
+        if (nIdle > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cvTask.notify_one();
+        }
+    }
+
+    Instance * pop(int iQueue) {
+        const int n = (int) queues.size();
+        for (int k = 0; k < n; ++k) {
+            auto & queue = *queues[(iQueue + k) % n];
+
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+
+            Instance * result = nullptr;
+            if (k == 0) {
+                result = queue.tasks.front();
+                queue.tasks.pop_front();
+            } else {
+                result = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            --nTasks;
+
+            return result;
+        }
+
+        return nullptr;
+    }
+
+    // decode the next frame of the decoder and queue the one after it on the same thread
+    void run(Instance & instance, int iQueue) {
+        // the decoder asks for the rest of the current frame - it gets what is available, once
+        bool hasProvided = false;
+        instance.decoder->decode([&](void * data, uint32_t nMaxBytes) {
+            if (hasProvided) {
+                return 0u;
+            }
+            hasProvided = true;
+
+            std::lock_guard<std::mutex> lock(instance.mutex);
+            const uint32_t n = (uint32_t) std::min(size_t(nMaxBytes), instance.input.size() - instance.offset);
+            std::copy(instance.input.begin() + instance.offset, instance.input.begin() + instance.offset + n, (uint8_t *) data);
+            instance.offset += n;
+
+            return n;
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(instance.mutex);
+            if (instance.offset < instance.input.size()) {
+                push(&instance, iQueue);
+                return;
+            }
+
+            instance.input.clear();
+            instance.offset = 0;
+            instance.isScheduled = false;
+        }
+
+        if (--nScheduled == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cvDone.notify_all();
+        }
+    }
+
+    void work(int iQueue) {
+        while (true) {
+            Instance * instance = pop(iQueue);
+            if (instance) {
+                run(*instance, iQueue);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            ++nIdle;
+            cvTask.wait(lock, [&]() { return isRunning == false || nTasks > 0; });
+            --nIdle;
+            if (isRunning == false) {
+                return;
+            }
+        }
+    }
+};
+
+GGMorseDecoderPool::GGMorseDecoderPool(int nThreads) : m_impl(new Impl()) {
+    if (nThreads <= 0) {
+        nThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < nThreads; ++i) {
+        m_impl->queues.emplace_back(new Impl::Queue());
+    }
+
+    for (int i = 0; i < nThreads; ++i) {
+        m_impl->workers.emplace_back([this, i]() { m_impl->work(i); });
+    }
+}
+
+GGMorseDecoderPool::~GGMorseDecoderPool() {
+    wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        m_impl->isRunning = false;
+    }
+    m_impl->cvTask.notify_all();
+
+    for (auto & worker : m_impl->workers) {
+        worker.join();
+    }
+}
+
+bool GGMorseDecoderPool::decode(GGMorseDecoder & decoder, const void * data, size_t nBytes) {
+    if (nBytes == 0) {
+        return true;
+    }
+
+    Impl::Instance * instance = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_impl->mutex);
+        auto & cur = m_impl->instances[&decoder];
+        if (cur == nullptr) {
+            cur.reset(new Impl::Instance());
+            cur->decoder = &decoder;
+        }
+        instance = cur.get();
+    }
+
+    const uint8_t * src = reinterpret_cast<const uint8_t *>(data);
+
+    {
+        std::lock_guard<std::mutex> lock(instance->mutex);
+        instance->input.erase(instance->input.begin(), instance->input.begin() + instance->offset);
+        instance->offset = 0;
+        instance->input.insert(instance->input.end(), src, src + nBytes);
+
+        if (instance->isScheduled) {
+            return true;
         }
+        instance->isScheduled = true;
     }
 
-    m_impl->alphabet[s01] = c;
+    ++m_impl->nScheduled;
+    m_impl->push(instance, m_impl->nextQueue);
+    m_impl->nextQueue = (m_impl->nextQueue + 1) % (int) m_impl->queues.size();
 
     return true;
 }
+
+void GGMorseDecoderPool::wait() {
+    std::unique_lock<std::mutex> lock(m_impl->mutex);
+    m_impl->cvDone.wait(lock, [&]() { return m_impl->nScheduled == 0; });
+
+    // the decoders may be gone after this, so nothing about them is kept
+    m_impl->instances.clear();
+}
+
+int GGMorseDecoderPool::getThreads() const { return (int) m_impl->workers.size(); }
+
+//
+// GGMorse
+//
+
+GGMorse::GGMorse(const Parameters & parameters)
+    : m_encoder(new GGMorseEncoder(parameters)),
+      m_decoder(new GGMorseDecoder(parameters)) {
+}
+
+GGMorse::~GGMorse() {
+}
+
+bool GGMorse::init(int dataSize, const char * dataBuffer) { return m_encoder->init(dataSize, dataBuffer); }
+
+bool GGMorse::setParametersDecode(const ParametersDecode & parameters) { return m_decoder->setParametersDecode(parameters); }
+bool GGMorse::setParametersEncode(const ParametersEncode & parameters) { return m_encoder->setParametersEncode(parameters); }
+
+bool GGMorse::encode(const CBWaveformOut & cbWaveformOut) { return m_encoder->encode(cbWaveformOut); }
+uint32_t GGMorse::encode(void * data, uint32_t nMaxBytes) { return m_encoder->encode(data, nMaxBytes); }
+bool GGMorse::append(int dataSize, const char * dataBuffer) { return m_encoder->append(dataSize, dataBuffer); }
+bool GGMorse::setKeyer(bool enabled) { return m_encoder->setKeyer(enabled); }
+
+uint32_t GGMorse::encodeSize_bytes() const { return m_encoder->encodeSize_bytes(); }
+uint32_t GGMorse::encodeSize_samples() const { return m_encoder->encodeSize_samples(); }
+
+bool GGMorse::decode(const CBWaveformInp & cbWaveformInp) {
+    if (m_encoder->hasTxData()) {
+        return false;
+    }
+
+    return m_decoder->decode(cbWaveformInp);
+}
+
+bool GGMorse::decode(const void * data, size_t nBytes) { return m_decoder->decode(data, nBytes); }
+
+const bool & GGMorse::hasTxData() const { return m_encoder->hasTxData(); }
+const bool & GGMorse::lastDecodeResult() const { return m_decoder->lastDecodeResult(); }
+
+const int & GGMorse::getSamplesPerFrame() const { return m_decoder->getSamplesPerFrame(); }
+const int & GGMorse::getSampleSizeBytesInp() const { return m_decoder->getSampleSizeBytesInp(); }
+const int & GGMorse::getSampleSizeBytesOut() const { return m_encoder->getSampleSizeBytesOut(); }
+
+const float & GGMorse::getSampleRateInp() const { return m_decoder->getSampleRateInp(); }
+const float & GGMorse::getSampleRateOut() const { return m_encoder->getSampleRateOut(); }
+const GGMorse::SampleFormat & GGMorse::getSampleFormatInp() const { return m_decoder->getSampleFormatInp(); }
+const GGMorse::SampleFormat & GGMorse::getSampleFormatOut() const { return m_encoder->getSampleFormatOut(); }
+const int & GGMorse::getChannelsInp() const { return m_decoder->getChannelsInp(); }
+
+GGMorseDecoder * GGMorse::getChannelDecoder(int channel) { return m_decoder->getChannelDecoder(channel); }
+
+const GGMorse::TxRx & GGMorse::getRxData() const { return m_decoder->getRxData(); }
+
+int GGMorse::takeRxData(TxRx & dst) { return m_decoder->takeRxData(dst); }
+int GGMorse::takeSignalF(SignalF & dst) { return m_decoder->takeSignalF(dst); }
+int GGMorse::takeTxWaveformI16(WaveformI16 & dst) { return m_encoder->takeTxWaveformI16(dst); }
+int GGMorse::takeSkimmerData(std::vector<SkimmerData> & dst) { return m_decoder->takeSkimmerData(dst); }
+
+const GGMorse::Statistics & GGMorse::getStatistics() const { return m_decoder->getStatistics(); }
+const GGMorse::Spectrogram GGMorse::getSpectrogram() const { return m_decoder->getSpectrogram(); }
+
+bool GGMorse::setCharacter(const std::string & s01, char c) {
+    return m_encoder->setCharacter(s01, c) && m_decoder->setCharacter(s01, c);
+}
+
+bool GGMorse::setCharacter(const std::string & s01, const std::string & text) {
+    return m_encoder->setCharacter(s01, text) && m_decoder->setCharacter(s01, text);
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "history.h"
+#include "tables.h"
+
 #include <vector>
 #include <cmath>
 
@@ -9,16 +12,10 @@ struct GoertzelRunningFIR {
             int window_samples,
             float history_s) {
         m_sampleRate = sampleRate;
-        m_hamming.resize(window_samples);
-        for (int i = 0; i < window_samples; i++) {
-            m_hamming[i] = 0.54 - 0.46*std::cos((2.0*M_PI*i)/window_samples);
-        }
+        m_hamming = &sharedTable<HammingWindow>(window_samples).w;
 
         int history_samples = history_s*sampleRate;
 
-        m_historyHead = 0;
-        m_history.resize(history_samples, 0);
-
         m_filteredHead = 0;
         m_filtered.resize(history_samples - window_samples, 0);
         m_filteredOut.resize(history_samples - window_samples, 0);
@@ -26,9 +23,9 @@ struct GoertzelRunningFIR {
         m_processed_samples = 0;
     }
 
-    void process(float * samples, int n, float frequency_hz) {
-        int nw = (int) m_hamming.size();
-        int nh = (int) m_history.size();
+    // the last n samples in the history are new
+    void process(const History & history, int n, float frequency_hz) {
+        int nw = (int) m_hamming->size();
         int nf = (int) m_filtered.size();
 
         float normalizedfreq = frequency_hz/m_sampleRate;
@@ -41,16 +38,13 @@ struct GoertzelRunningFIR {
         m_cos = wr;
         m_sin = wi;
 
+        int end = history.head() - n;
         for (int i = 0; i < n; ++i) {
-            m_history[m_historyHead] = samples[i];
-            m_historyHead++;
-            if (m_historyHead >= nh) {
-                m_historyHead = 0;
-            }
+            ++end;
 
             m_processed_samples++;
             if (m_processed_samples >= nw) {
-                m_filtered[m_filteredHead] = filter(m_historyHead - nw);
+                m_filtered[m_filteredHead] = filter(history.view(end - nw));
                 m_filteredHead++;
                 if (m_filteredHead >= nf) {
                     m_filteredHead = 0;
@@ -59,9 +53,10 @@ struct GoertzelRunningFIR {
         }
     }
 
-    void recompute(float frequency_hz) {
-        int nw = (int) m_hamming.size();
-        int nh = (int) m_history.size();
+    // recompute the output for all samples in the history
+    void recompute(const History & history, float frequency_hz) {
+        int nw = (int) m_hamming->size();
+        int nh = history.size();
         int nf = (int) m_filtered.size();
 
         float normalizedfreq = frequency_hz/m_sampleRate;
@@ -76,15 +71,13 @@ struct GoertzelRunningFIR {
 
         m_processed_samples = 0;
 
+        int end = history.head();
         for (int i = 0; i < nh; ++i) {
-            m_historyHead++;
-            if (m_historyHead >= nh) {
-                m_historyHead = 0;
-            }
+            ++end;
 
             m_processed_samples++;
             if (m_processed_samples >= nw) {
-                m_filtered[m_filteredHead] = filter(m_historyHead - nw);
+                m_filtered[m_filteredHead] = filter(history.view(end - nw));
                 m_filteredHead++;
                 if (m_filteredHead >= nf) {
                     m_filteredHead = 0;
@@ -134,22 +127,19 @@ struct GoertzelRunningFIR {
 
     void clear() {
         m_processed_samples = 0;
-        std::fill(m_history.begin(), m_history.end(), 0.0f);
         std::fill(m_filtered.begin(), m_filtered.end(), 0.0f);
     }
 
 private:
-    float filter(int idx) {
-        if (idx < 0) idx += m_history.size();
-
+    float filter(const float * samples) {
         double sprev = 0.0;
         double sprev2 = 0.0;
         double s, imag, real;
 
-        int n = (int) m_hamming.size();
+        int n = (int) m_hamming->size();
+        const float * hamming = m_hamming->data();
         for (int i = 0; i < n; i++) {
-            s = m_hamming[i]*m_history[idx++] + m_coeff*sprev - sprev2;
-            if (idx >= (int) m_history.size()) idx = 0;
+            s = hamming[i]*samples[i] + m_coeff*sprev - sprev2;
             sprev2 = sprev;
             sprev = s;
         }
@@ -167,10 +157,8 @@ private:
     float m_sin = 0.0f;
     float m_cos = 0.0f;
 
-    std::vector<float> m_hamming;
-
-    int m_historyHead = 0;
-    std::vector<float> m_history;
+    // shared with the other instances, see tables.h
+    const std::vector<float> * m_hamming = nullptr;
 
     int m_filteredHead = 0;
     std::vector<float> m_filtered;
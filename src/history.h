@@ -0,0 +1,128 @@
+#pragma once
+
+#include "filter.h"
+
+#include <algorithm>
+#include <vector>
+
+// Ring buffer with the most recent base-rate samples, shared by the analysis stages
+//
+// The first maxView samples of the ring are mirrored after its end, so any window of up to maxView samples
+// can be read as a contiguous array, regardless of where it is in the ring. Only the writes to the first
+// maxView positions are duplicated.
+//
+// Frames can also be assembled in place: new samples are written after the head, at the write cursor, and
+// commit() makes them part of the history once the frame is complete. Nothing is copied or moved.
+//
+struct History {
+    void init(int size, int maxView) {
+        m_size = size;
+        m_maxView = maxView;
+        m_head = 0;
+        m_write = 0;
+        m_data.assign(size + maxView, 0.0f);
+    }
+
+    void clear() {
+        m_head = 0;
+        m_write = 0;
+        std::fill(m_data.begin(), m_data.end(), 0.0f);
+    }
+
+    // if a filter is provided, it is applied to the samples on their way into the ring
+    // any uncommitted samples are discarded
+    void push(const float * samples, int n, Filter * filter = nullptr) {
+        while (n > 0) {
+            const int len = std::min(n, m_size - m_head);
+
+            float * dst = m_data.data() + m_head;
+            if (filter) {
+                filter->process(samples, dst, len);
+            } else {
+                std::copy(samples, samples + len, dst);
+            }
+
+            if (m_head < m_maxView) {
+                const int nMirror = std::min(len, m_maxView - m_head);
+                std::copy(dst, dst + nMirror, dst + m_size);
+            }
+
+            m_head += len;
+            if (m_head >= m_size) {
+                m_head = 0;
+            }
+
+            samples += len;
+            n -= len;
+        }
+
+        m_write = m_head;
+    }
+
+    // where the next uncommitted sample is written
+    float * writePtr() { return m_data.data() + m_write; }
+
+    // number of samples that can be written at writePtr() before the end of the ring
+    int writeAvailable() const { return m_size - m_write; }
+
+    // mark n samples at writePtr() as written
+    void advance(int n) {
+        m_write += n;
+        if (m_write >= m_size) {
+            m_write = 0;
+        }
+    }
+
+    // number of written samples that are not committed yet
+    int pending() const {
+        return m_write >= m_head ? m_write - m_head : m_write + m_size - m_head;
+    }
+
+    // append the written samples to the history, filtering them in place if a filter is provided
+    void commit(Filter * filter = nullptr) {
+        int n = pending();
+        while (n > 0) {
+            const int len = std::min(n, m_size - m_head);
+
+            float * dst = m_data.data() + m_head;
+            if (filter) {
+                filter->process(dst, len);
+            }
+
+            if (m_head < m_maxView) {
+                const int nMirror = std::min(len, m_maxView - m_head);
+                std::copy(dst, dst + nMirror, dst + m_size);
+            }
+
+            m_head += len;
+            if (m_head >= m_size) {
+                m_head = 0;
+            }
+
+            n -= len;
+        }
+    }
+
+    // total number of samples in the ring
+    int size() const { return m_size; }
+
+    // position in the ring after the last committed sample
+    int head() const { return m_head; }
+
+    // contiguous view of up to maxView samples, starting at the given position
+    // the position is wrapped around the ring, so it can be negative or past the end
+    const float * view(int idx) const {
+        idx %= m_size;
+        if (idx < 0) idx += m_size;
+
+        return m_data.data() + idx;
+    }
+
+private:
+    int m_size = 0;
+    int m_maxView = 0;
+    int m_head = 0;
+    int m_write = 0;
+
+    std::vector<float> m_data;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "filter.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Sine oscillator of the encoder
+//
+// kLanes unit phasors, each a step ahead of the previous one, are rotated together by kLanes steps per
+// iteration. The lanes are independent, so the loop vectorizes, and no trigonometric functions are evaluated
+// per sample. The phasors are seeded from the exact phase on every call, so the rounding errors of the
+// rotation do not accumulate beyond one call.
+//
+struct Oscillator {
+    static constexpr int kLanes = 8;
+
+    void init(float frequency_hz, float sampleRate) {
+        m_frequency = frequency_hz;
+        m_sampleRate = sampleRate;
+
+        const double w = 2.0*pi*double(frequency_hz)/double(sampleRate);
+
+        m_stepRe = std::cos(w);
+        m_stepIm = std::sin(w);
+
+        m_stepLanesRe = std::cos(kLanes*w);
+        m_stepLanesIm = std::sin(kLanes*w);
+    }
+
+    // phase of sample number t
+    double phase(int64_t t) const {
+        return 2.0*pi*std::fmod(double(t)*m_frequency/m_sampleRate, 1.0);
+    }
+
+    // n samples of the sine wave, starting with sample number t0
+    void generate(float * dst, int n, int64_t t0) const {
+        const double phase = this->phase(t0);
+
+        float re[kLanes];
+        float im[kLanes];
+
+        double r = std::cos(phase);
+        double i = std::sin(phase);
+        for (int k = 0; k < kLanes; ++k) {
+            re[k] = r;
+            im[k] = i;
+
+            const double t = r*m_stepRe - i*m_stepIm;
+            i = r*m_stepIm + i*m_stepRe;
+            r = t;
+        }
+
+        const float cs = m_stepLanesRe;
+        const float sn = m_stepLanesIm;
+
+        int j = 0;
+        for (; j + kLanes <= n; j += kLanes) {
+            for (int k = 0; k < kLanes; ++k) {
+                dst[j + k] = im[k];
+
+                const float t = re[k]*cs - im[k]*sn;
+                im[k] = re[k]*sn + im[k]*cs;
+                re[k] = t;
+            }
+        }
+
+        for (int k = 0; j + k < n; ++k) {
+            dst[j + k] = im[k];
+        }
+    }
+
+private:
+    double m_frequency = 0.0;
+    double m_sampleRate = 1.0;
+
+    double m_stepRe = 1.0;
+    double m_stepIm = 0.0;
+
+    double m_stepLanesRe = 1.0;
+    double m_stepLanesIm = 0.0;
+};
+
+// Tone with a fixed envelope, rendered at any starting phase
+//
+// The tone is stored as its sine and cosine components, env(i)*sin(i*w) and env(i)*cos(i*w). Starting at phase
+// p, the tone is env(i)*sin(p + i*w) = cos(p)*env(i)*sin(i*w) + sin(p)*env(i)*cos(i*w), so rendering takes two
+// multiply-adds per sample and is exact for every phase.
+//
+struct ToneTemplate {
+    void init(const std::vector<float> & envelope, float frequency_hz, float sampleRate) {
+        const int n = (int) envelope.size();
+        const double w = 2.0*pi*double(frequency_hz)/double(sampleRate);
+
+        m_sin.resize(n);
+        m_cos.resize(n);
+        for (int i = 0; i < n; ++i) {
+            m_sin[i] = envelope[i]*std::sin(i*w);
+            m_cos[i] = envelope[i]*std::cos(i*w);
+        }
+    }
+
+    int size() const { return (int) m_sin.size(); }
+
+    // n samples starting at sample offset of the tone, which started at the given phase
+    void render(float * dst, int n, int offset, double phase) const {
+        const float a = std::cos(phase);
+        const float b = std::sin(phase);
+
+        const float * s = m_sin.data() + offset;
+        const float * c = m_cos.data() + offset;
+        for (int i = 0; i < n; ++i) {
+            dst[i] = a*s[i] + b*c[i];
+        }
+    }
+
+private:
+    std::vector<float> m_sin;
+    std::vector<float> m_cos;
+};
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "fft.h"
+#include "history.h"
+#include "tables.h"
 
+#include <algorithm>
 #include <vector>
 #include <cmath>
 
@@ -13,14 +16,10 @@ struct STFFT {
             float history_s) {
         m_sampleRate = sampleRate;
 
-        m_hamming.resize(fft_size);
-        for (int i = 0; i < fft_size; i++) {
-            m_hamming[i] = 0.54 - 0.46*std::cos((2.0*M_PI*i)/fft_size);
-        }
+        m_hamming = &sharedTable<HammingWindow>(fft_size).w;
+        m_fft = &sharedTable<FFTTables>(fft_size);
 
         int history_samples = history_s*sampleRate;
-        m_historyHead = 0;
-        m_history.resize(history_samples, 0);
 
         int historySteps = 1 + (history_samples - fft_size)/fft_step;
         m_spectrogramHead = 0;
@@ -28,7 +27,8 @@ struct STFFT {
         for (auto & row : m_spectrogram) {
             row.resize(fft_size, 0);
         }
-        m_spectrogramOrdered = m_spectrogram;
+        m_spectrogramOrdered.clear();
+        m_average.resize(fft_size/2);
 
         m_needed_samples = fft_step;
         m_fft_step = fft_step;
@@ -37,23 +37,20 @@ struct STFFT {
         m_processed_samples = 0;
     }
 
-    void process(float * samples, int n) {
-        int nw = (int) m_hamming.size();
-        int nh = (int) m_history.size();
+    // the last n samples in the history are new
+    void process(const History & history, int n) {
+        int nw = (int) m_hamming->size();
         int ns = (int) m_spectrogram.size();
 
+        int end = history.head() - n;
         for (int i = 0; i < n; ++i) {
-            m_history[m_historyHead] = samples[i];
-            m_historyHead++;
-            if (m_historyHead >= nh) {
-                m_historyHead = 0;
-            }
+            ++end;
 
             m_processed_samples++;
 
             m_needed_samples--;
             if (m_needed_samples == 0) {
-                filter(m_historyHead - nw);
+                filter(history.view(end - nw));
                 m_spectrogramHead++;
                 if (m_spectrogramHead >= ns) {
                     m_spectrogramHead = 0;
@@ -64,42 +61,84 @@ struct STFFT {
     }
 
     float pitch(float fMin_hz, float fMax_hz) {
-        int n = (int) m_hamming.size();
-        int ns = (int) m_spectrogram.size();
+        int n = (int) m_hamming->size();
         float maxSignal = 0.0f;
         float bestPitch = 0.0f;
         float df = float(m_sampleRate)/n;
 
+        average(fMin_hz, fMax_hz);
+
         for (int j = 0; j < n/2; ++j) {
             float f = j*df;
             if (f < fMin_hz || f > fMax_hz) continue;
 
-            float curSignal = 0.0;
-
-            int ih = m_spectrogramHead + ns/2;
-            if (ih >= ns) {
-                ih = 0;
+            if (m_average[j] > maxSignal) {
+                maxSignal = m_average[j];
+                bestPitch = f;
             }
-            for (int i = 0; i < ns/2; ++i) {
-                curSignal += m_spectrogram[ih][j];
-                ++ih;
-                if (ih >= ns) {
-                    ih = 0;
-                }
+        }
+
+        return bestPitch;
+    }
+
+    // find up to nMax tones in the range, strongest first
+    // a tone is a bin that is the strongest within +/- spacing_hz and at least threshold times above the lower
+    // quartile of the range - a noise floor estimate that holds as long as a quarter of the bins have no signal
+    // the floor is limited to 50 dB below the strongest bin, about the sidelobe level of the window, so that the
+    // leakage of a clean signal is not taken for tones
+    int peaks(float fMin_hz, float fMax_hz, float spacing_hz, float threshold, float * dst, int nMax) {
+        int n = (int) m_hamming->size();
+        float df = float(m_sampleRate)/n;
+
+        average(fMin_hz, fMax_hz);
+
+        const int j0 = std::max(0, (int) std::ceil(fMin_hz/df));
+        const int j1 = std::min(n/2 - 1, (int) std::floor(fMax_hz/df));
+        if (j1 < j0) {
+            return 0;
+        }
+
+        m_sorted.assign(m_average.begin() + j0, m_average.begin() + j1 + 1);
+        std::nth_element(m_sorted.begin(), m_sorted.begin() + m_sorted.size()/4, m_sorted.end());
+
+        const float floor = std::max(m_sorted[m_sorted.size()/4], 1e-5f*(*std::max_element(m_sorted.begin(), m_sorted.end())));
+        const float level = threshold*floor;
+        const int dj = std::max(1, (int) std::round(spacing_hz/df));
+
+        m_peaks.clear();
+        for (int j = j0; j <= j1; ++j) {
+            if (m_average[j] <= level) continue;
+
+            bool isPeak = true;
+            for (int k = std::max(j0, j - dj); k <= std::min(j1, j + dj) && isPeak; ++k) {
+                // ties go to the lower bin
+                isPeak = k == j || m_average[k] < m_average[j] || (m_average[k] == m_average[j] && k > j);
             }
 
-            if (curSignal > maxSignal) {
-                maxSignal = curSignal;
-                bestPitch = f;
+            if (isPeak) {
+                m_peaks.push_back(j);
             }
         }
 
-        return bestPitch;
+        std::sort(m_peaks.begin(), m_peaks.end(), [this](int a, int b) { return m_average[a] > m_average[b]; });
+
+        const int nPeaks = std::min(nMax, (int) m_peaks.size());
+        for (int i = 0; i < nPeaks; ++i) {
+            dst[i] = m_peaks[i]*df;
+        }
+
+        return nPeaks;
     }
 
     const std::vector<std::vector<float>> & spectrogram() {
-        int n = (int) m_hamming.size();
+        int n = (int) m_hamming->size();
         int ns = (int) m_spectrogram.size();
+
+        // allocated on first use - most instances never look at the spectrogram
+        if (m_spectrogramOrdered.size() != m_spectrogram.size()) {
+            m_spectrogramOrdered = m_spectrogram;
+        }
+
         int ih = m_spectrogramHead;
         for (int i = 0; i < ns; ++i) {
             for (int j = 0; j < n; ++j) {
@@ -115,17 +154,43 @@ struct STFFT {
     }
 
 private:
-    void filter(int idx) {
-        if (idx < 0) idx += m_history.size();
+    // power of the bins in the range, summed over the recent half of the spectrogram
+    void average(float fMin_hz, float fMax_hz) {
+        int n = (int) m_hamming->size();
+        int ns = (int) m_spectrogram.size();
+        float df = float(m_sampleRate)/n;
 
-        int n = (int) m_hamming.size();
+        for (int j = 0; j < n/2; ++j) {
+            float f = j*df;
+            if (f < fMin_hz || f > fMax_hz) continue;
+
+            float curSignal = 0.0;
+
+            int ih = m_spectrogramHead + ns/2;
+            if (ih >= ns) {
+                ih = 0;
+            }
+            for (int i = 0; i < ns/2; ++i) {
+                curSignal += m_spectrogram[ih][j];
+                ++ih;
+                if (ih >= ns) {
+                    ih = 0;
+                }
+            }
+
+            m_average[j] = curSignal;
+        }
+    }
+
+    void filter(const float * samples) {
+        int n = (int) m_hamming->size();
+        const float * hamming = m_hamming->data();
         for (int i = 0; i < n; i++) {
-            m_fft_buffer[2*i + 0] = m_hamming[i]*m_history[idx++];
+            m_fft_buffer[2*i + 0] = hamming[i]*samples[i];
             m_fft_buffer[2*i + 1] = 0.0f;
-            if (idx >= (int) m_history.size()) idx = 0;
         }
 
-        FFT(m_fft_buffer.data(), n, 1.0);
+        FFT(m_fft_buffer.data(), *m_fft, 1.0);
 
         auto & dst = m_spectrogram[m_spectrogramHead];
         for (int i = 0; i < n; i++) {
@@ -137,10 +202,9 @@ private:
     int m_processed_samples = 0;
     int m_fft_step = 0;
 
-    std::vector<float> m_hamming;
-
-    int m_historyHead = 0;
-    std::vector<float> m_history;
+    // shared with the other instances, see tables.h
+    const std::vector<float> * m_hamming = nullptr;
+    const FFTTables * m_fft = nullptr;
 
     int m_needed_samples = 0;
     int m_spectrogramHead = 0;
@@ -148,4 +212,8 @@ private:
     std::vector<std::vector<float>> m_spectrogramOrdered;
 
     std::vector<float> m_fft_buffer;
+
+    std::vector<float> m_average;
+    std::vector<float> m_sorted;
+    std::vector<int> m_peaks;
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Read-only tables, shared by all instances in the process
+//
+// A table depends only on its size and is built by the first instance that asks for it - the rest of the
+// instances get a reference to the same table. Tables are never modified or freed, so the references stay valid
+// for the lifetime of the process and can be read from any thread without locking. Only the lookup is locked.
+//
+template <typename Table>
+const Table & sharedTable(int size) {
+    static std::mutex mutex;
+    static std::map<int, std::unique_ptr<const Table>> tables;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto & table = tables[size];
+    if (!table) {
+        table.reset(new Table(size));
+    }
+
+    return *table;
+}
+
+struct HammingWindow {
+    explicit HammingWindow(int n) : w(n) {
+        for (int i = 0; i < n; i++) {
+            w[i] = 0.54 - 0.46*std::cos((2.0*M_PI*i)/n);
+        }
+    }
+
+    std::vector<float> w;
+};